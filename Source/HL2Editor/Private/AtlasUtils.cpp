@@ -0,0 +1,180 @@
+#include "AtlasUtils.h"
+
+#include "StaticMeshAttributes.h"
+
+TArray<int> FAtlasUtils::PackTiles(TArrayView<FAtlasTile> tiles, int atlasSize, int padding)
+{
+	TArray<int> packOrder;
+	packOrder.Reserve(tiles.Num());
+	for (int tileIndex = 0; tileIndex < tiles.Num(); ++tileIndex)
+	{
+		packOrder.Add(tileIndex);
+	}
+	packOrder.StableSort([&](const int a, const int b)
+	{
+		if (tiles[a].Bucket != tiles[b].Bucket) { return tiles[a].Bucket < tiles[b].Bucket; }
+		return tiles[a].Size.Y > tiles[b].Size.Y;
+	});
+
+	TArray<int> pageBuckets;
+	int shelfX = 0, shelfY = 0, shelfHeight = 0;
+	for (const int tileIndex : packOrder)
+	{
+		FAtlasTile& tile = tiles[tileIndex];
+		const int width = tile.Size.X + padding * 2;
+		const int height = tile.Size.Y + padding * 2;
+		check(width <= atlasSize && height <= atlasSize);
+		if (pageBuckets.Num() > 0 && pageBuckets.Last() == tile.Bucket && shelfX + width > atlasSize)
+		{
+			shelfX = 0;
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (pageBuckets.Num() == 0 || pageBuckets.Last() != tile.Bucket || shelfY + height > atlasSize)
+		{
+			pageBuckets.Add(tile.Bucket);
+			shelfX = shelfY = shelfHeight = 0;
+		}
+		tile.Page = pageBuckets.Num() - 1;
+		tile.Rect = FBox2f(
+			FVector2f(shelfX + padding, shelfY + padding) / atlasSize,
+			FVector2f(shelfX + width - padding, shelfY + height - padding) / atlasSize
+		);
+		shelfX += width;
+		shelfHeight = FMath::Max(shelfHeight, height);
+	}
+	return pageBuckets;
+}
+
+bool FAtlasUtils::IsSourceCompatible(ETextureSourceFormat format, int width, int height, int mipCount)
+{
+	if (format != TSF_BGRA8) { return false; }
+	const int alignment = 1 << FMath::Max(mipCount - 1, 0);
+	return width > 0 && height > 0 && width % alignment == 0 && height % alignment == 0;
+}
+
+bool FAtlasUtils::WriteTile(TArrayView<uint8* const> atlasMips, int atlasSize, const FIntPoint& dest, TArray64<uint8> tileData, int width, int height, int padding)
+{
+	if (!IsSourceCompatible(TSF_BGRA8, width, height, atlasMips.Num())) { return false; }
+	if (tileData.Num() != (int64)width * height * 4) { return false; }
+
+	// The padding and destination halve with every mip, so they must stay on whole texels too
+	const int alignment = 1 << FMath::Max(atlasMips.Num() - 1, 0);
+	if (padding % alignment != 0 || dest.X % alignment != 0 || dest.Y % alignment != 0) { return false; }
+	if (dest.X < 0 || dest.Y < 0 || dest.X + width + padding * 2 > atlasSize || dest.Y + height + padding * 2 > atlasSize) { return false; }
+
+	for (int mip = 0; mip < atlasMips.Num(); ++mip)
+	{
+		if (mip > 0)
+		{
+			TArray64<uint8> halfData;
+			DownsampleBGRA8(tileData, width, height, halfData);
+			tileData = MoveTemp(halfData);
+			width /= 2;
+			height /= 2;
+		}
+		const int mipSize = atlasSize >> mip;
+		const int mipPadding = padding >> mip;
+		const int destX = dest.X >> mip;
+		const int destY = dest.Y >> mip;
+
+		// Wrap into the padding so bilinear filtering at the edges matches the tiling source
+		for (int y = 0; y < height + mipPadding * 2; ++y)
+		{
+			const int sourceY = ((y - mipPadding) % height + height) % height;
+			for (int x = 0; x < width + mipPadding * 2; ++x)
+			{
+				const int sourceX = ((x - mipPadding) % width + width) % width;
+				FMemory::Memcpy(
+					atlasMips[mip] + ((int64)(destY + y) * mipSize + destX + x) * 4,
+					tileData.GetData() + ((int64)sourceY * width + sourceX) * 4,
+					4
+				);
+			}
+		}
+	}
+	return true;
+}
+
+void FAtlasUtils::DownsampleBGRA8(const TArray64<uint8>& source, int width, int height, TArray64<uint8>& outData)
+{
+	check(width % 2 == 0 && height % 2 == 0);
+	const int halfWidth = width / 2;
+	const int halfHeight = height / 2;
+	outData.SetNumUninitialized((int64)halfWidth * halfHeight * 4);
+	for (int y = 0; y < halfHeight; ++y)
+	{
+		for (int x = 0; x < halfWidth; ++x)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				int sum = 0;
+				for (int sampleY = 0; sampleY < 2; ++sampleY)
+				{
+					for (int sampleX = 0; sampleX < 2; ++sampleX)
+					{
+						sum += source[((int64)(y * 2 + sampleY) * width + x * 2 + sampleX) * 4 + channel];
+					}
+				}
+				outData[((int64)y * halfWidth + x) * 4 + channel] = (uint8)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+bool FAtlasUtils::FitsInTile(const FMeshDescription& meshDesc, FPolygonGroupID polyGroupID)
+{
+	const FStaticMeshConstAttributes staticMeshAttr(meshDesc);
+	const TVertexInstanceAttributesConstRef<FVector2f> vertexInstanceAttrUV = staticMeshAttr.GetVertexInstanceUVs();
+	for (const FPolygonID polyID : meshDesc.GetPolygonGroupPolygonIDs(polyGroupID))
+	{
+		FBox2f uvBounds(ForceInit);
+		for (const FVertexInstanceID vertInstID : meshDesc.GetPolygonVertexInstanceIDs(polyID))
+		{
+			uvBounds += vertexInstanceAttrUV.Get(vertInstID, 0);
+		}
+		const FVector2f tile(FMath::FloorToFloat(uvBounds.Min.X + KINDA_SMALL_NUMBER), FMath::FloorToFloat(uvBounds.Min.Y + KINDA_SMALL_NUMBER));
+		if (uvBounds.Max.X - tile.X > 1.0f + KINDA_SMALL_NUMBER || uvBounds.Max.Y - tile.Y > 1.0f + KINDA_SMALL_NUMBER) { return false; }
+	}
+	return true;
+}
+
+void FAtlasUtils::MergeSections(FMeshDescription& meshDesc, TArrayView<const FAtlasSectionMerge> merges)
+{
+	FStaticMeshAttributes staticMeshAttr(meshDesc);
+	TMeshAttributesRef<FPolygonGroupID, FName> polyGroupMaterial = staticMeshAttr.GetPolygonGroupMaterialSlotNames();
+	TMeshAttributesRef<FVertexInstanceID, FVector2f> vertexInstanceAttrUV = staticMeshAttr.GetVertexInstanceUVs();
+	TMap<FName, FPolygonGroupID> pageToPolyGroup;
+	TSet<FVertexInstanceID> remappedVertInsts;
+	for (const FAtlasSectionMerge& merge : merges)
+	{
+		FPolygonGroupID* pagePolyGroupID = pageToPolyGroup.Find(merge.PageSlotName);
+		if (pagePolyGroupID == nullptr)
+		{
+			pagePolyGroupID = &pageToPolyGroup.Add(merge.PageSlotName, meshDesc.CreatePolygonGroup());
+			polyGroupMaterial[*pagePolyGroupID] = merge.PageSlotName;
+		}
+		const TArray<FPolygonID> polyIDs = meshDesc.GetPolygonGroupPolygonIDs(merge.PolyGroup);
+		for (const FPolygonID polyID : polyIDs)
+		{
+			// Move the polygon's repeat of the texture onto the tile
+			const TArrayView<const FVertexInstanceID> vertInstIDs = meshDesc.GetPolygonVertexInstanceIDs(polyID);
+			FVector2f uvMin(TNumericLimits<float>::Max());
+			for (const FVertexInstanceID vertInstID : vertInstIDs)
+			{
+				uvMin = FVector2f::Min(uvMin, vertexInstanceAttrUV.Get(vertInstID, 0));
+			}
+			const FVector2f tile(FMath::FloorToFloat(uvMin.X + KINDA_SMALL_NUMBER), FMath::FloorToFloat(uvMin.Y + KINDA_SMALL_NUMBER));
+			for (const FVertexInstanceID vertInstID : vertInstIDs)
+			{
+				bool alreadyRemapped;
+				remappedVertInsts.Add(vertInstID, &alreadyRemapped);
+				if (alreadyRemapped) { continue; }
+				const FVector2f uv = (vertexInstanceAttrUV.Get(vertInstID, 0) - tile).ClampAxes(0.0f, 1.0f);
+				vertexInstanceAttrUV.Set(vertInstID, 0, merge.Rect.Min + uv * merge.Rect.GetSize());
+			}
+			meshDesc.SetPolygonPolygonGroup(polyID, *pagePolyGroupID);
+		}
+		meshDesc.DeletePolygonGroup(merge.PolyGroup);
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MeshDescription.h"
+#include "Engine/Texture.h"
+
+/** A texture to be placed into an atlas page. */
+struct FAtlasTile
+{
+	/** The size of the texture in texels, not including padding. */
+	FIntPoint Size = FIntPoint::ZeroValue;
+
+	/** Tiles only share a page with tiles of the same bucket. */
+	int Bucket = 0;
+
+	/** The page the tile was packed into. */
+	int Page = -1;
+
+	/** Where the tile was packed within its page, in normalised coordinates, not including padding. */
+	FBox2f Rect = FBox2f(ForceInit);
+};
+
+/** A polygon group to be merged into the section of an atlas page. */
+struct FAtlasSectionMerge
+{
+	FPolygonGroupID PolyGroup;
+
+	/** Where the texture of the polygon group was packed, in normalised coordinates. */
+	FBox2f Rect = FBox2f(ForceInit);
+
+	/** The material slot of the atlas page, polygon groups with the same slot are merged into one. */
+	FName PageSlotName;
+};
+
+class FAtlasUtils
+{
+private:
+
+	FAtlasUtils();
+
+public:
+
+	/**
+	 * Packs tiles into square pages in shelves, ordered by bucket and then by decreasing height.
+	 * Every tile is surrounded by the given padding, which must fit within the page along with the tile.
+	 * Returns the bucket of each page that was created.
+	 */
+	static TArray<int> PackTiles(TArrayView<FAtlasTile> tiles, int atlasSize, int padding);
+
+	/**
+	 * Gets whether a texture source can be copied into an atlas with the given number of mips.
+	 * Only BGRA8 sources are supported, and both dimensions must halve evenly down to the last mip.
+	 */
+	static bool IsSourceCompatible(ETextureSourceFormat format, int width, int height, int mipCount);
+
+	/**
+	 * Writes a BGRA8 tile and its mip chain into the mips of a BGRA8 atlas page, wrapping the tile into its padding.
+	 * Each mip is box filtered from the previous mip of the tile alone, so that neighbouring tiles never bleed in.
+	 * The destination is the top left of the padding at mip 0. Returns false, writing nothing, if the tile is not compatible.
+	 */
+	static bool WriteTile(TArrayView<uint8* const> atlasMips, int atlasSize, const FIntPoint& dest, TArray64<uint8> tileData, int width, int height, int padding);
+
+	/**
+	 * Halves a BGRA8 image with a box filter. The dimensions must be even.
+	 */
+	static void DownsampleBGRA8(const TArray64<uint8>& source, int width, int height, TArray64<uint8>& outData);
+
+	/**
+	 * Gets whether every polygon of the polygon group keeps its uvs within a single repeat of the texture, so that it can be remapped into an atlas.
+	 */
+	static bool FitsInTile(const FMeshDescription& meshDesc, FPolygonGroupID polyGroupID);
+
+	/**
+	 * Remaps the uvs of each polygon group into its atlas rect and moves its polygons into a new polygon group per atlas page.
+	 * The merged polygon groups are deleted.
+	 */
+	static void MergeSections(FMeshDescription& meshDesc, TArrayView<const FAtlasSectionMerge> merges);
+
+};
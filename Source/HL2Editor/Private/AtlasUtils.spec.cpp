@@ -0,0 +1,188 @@
+#include "Misc/AutomationTest.h"
+#include "AtlasUtils.h"
+#include "StaticMeshAttributes.h"
+
+BEGIN_DEFINE_SPEC(AtlasUtilsSpec, "HL2.AtlasUtils.Spec", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+FMeshDescription MeshDesc;
+FPolygonGroupID AddQuad(const FName slotName, const FVector2f& uvMin, const FVector2f& uvMax);
+int CountSections() const;
+END_DEFINE_SPEC(AtlasUtilsSpec)
+
+FPolygonGroupID AtlasUtilsSpec::AddQuad(const FName slotName, const FVector2f& uvMin, const FVector2f& uvMax)
+{
+	FStaticMeshAttributes staticMeshAttr(MeshDesc);
+	const FPolygonGroupID polyGroupID = MeshDesc.CreatePolygonGroup();
+	staticMeshAttr.GetPolygonGroupMaterialSlotNames()[polyGroupID] = slotName;
+	const FVector2f corners[] = { FVector2f(0.0f, 0.0f), FVector2f(1.0f, 0.0f), FVector2f(1.0f, 1.0f), FVector2f(0.0f, 1.0f) };
+	TArray<FVertexInstanceID> vertInstIDs;
+	for (const FVector2f& corner : corners)
+	{
+		const FVertexID vertID = MeshDesc.CreateVertex();
+		staticMeshAttr.GetVertexPositions()[vertID] = FVector3f(corner.X, corner.Y, 0.0f);
+		const FVertexInstanceID vertInstID = MeshDesc.CreateVertexInstance(vertID);
+		staticMeshAttr.GetVertexInstanceUVs().Set(vertInstID, 0, uvMin + corner * (uvMax - uvMin));
+		vertInstIDs.Add(vertInstID);
+	}
+	MeshDesc.CreatePolygon(polyGroupID, vertInstIDs);
+	return polyGroupID;
+}
+
+int AtlasUtilsSpec::CountSections() const
+{
+	int sections = 0;
+	for (const FPolygonGroupID polyGroupID : MeshDesc.PolygonGroups().GetElementIDs())
+	{
+		if (MeshDesc.GetNumPolygonGroupPolygons(polyGroupID) > 0) { ++sections; }
+	}
+	return sections;
+}
+
+void AtlasUtilsSpec::Define()
+{
+	Describe("FAtlasUtils", [this]()
+		{
+			Describe("PackTiles", [this]()
+				{
+					It("will only share pages within a bucket", [this]()
+						{
+							TArray<FAtlasTile> tiles;
+							tiles.AddDefaulted(3);
+							tiles[0].Size = FIntPoint(64, 64);
+							tiles[0].Bucket = 1;
+							tiles[1].Size = FIntPoint(32, 32);
+							tiles[1].Bucket = 0;
+							tiles[2].Size = FIntPoint(64, 32);
+							tiles[2].Bucket = 1;
+							const TArray<int> pageBuckets = FAtlasUtils::PackTiles(tiles, 256, 16);
+							if (!TestEqual("pageBuckets.Num()", pageBuckets.Num(), 2)) { return; }
+							TestEqual("tiles[0].Page", tiles[0].Page, tiles[2].Page);
+							TestNotEqual("tiles[1].Page", tiles[1].Page, tiles[0].Page);
+							TestEqual("page bucket", pageBuckets[tiles[0].Page], 1);
+						});
+
+					It("will leave the padding around each tile", [this]()
+						{
+							TArray<FAtlasTile> tiles;
+							tiles.AddDefaulted(2);
+							tiles[0].Size = FIntPoint(64, 64);
+							tiles[1].Size = FIntPoint(64, 64);
+							FAtlasUtils::PackTiles(tiles, 256, 16);
+							TestEqual("tiles[0].Rect.Min", tiles[0].Rect.Min, FVector2f(16.0f, 16.0f) / 256.0f);
+							TestEqual("tiles[0].Rect.Max", tiles[0].Rect.Max, FVector2f(80.0f, 80.0f) / 256.0f);
+							TestEqual("tiles[1].Rect.Min", tiles[1].Rect.Min, FVector2f(112.0f, 16.0f) / 256.0f);
+						});
+
+					It("will start a new page when a page is full", [this]()
+						{
+							TArray<FAtlasTile> tiles;
+							tiles.AddDefaulted(2);
+							tiles[0].Size = FIntPoint(96, 96);
+							tiles[1].Size = FIntPoint(96, 96);
+							const TArray<int> pageBuckets = FAtlasUtils::PackTiles(tiles, 128, 16);
+							TestEqual("pageBuckets.Num()", pageBuckets.Num(), 2);
+							TestEqual("tiles[1].Page", tiles[1].Page, 1);
+						});
+				});
+
+			Describe("WriteTile", [this]()
+				{
+					It("will reject sources that are not BGRA8 or not aligned to the mips", [this]()
+						{
+							TestFalse("G8", FAtlasUtils::IsSourceCompatible(TSF_G8, 64, 64, 4));
+							TestFalse("12x16", FAtlasUtils::IsSourceCompatible(TSF_BGRA8, 12, 16, 4));
+							TestTrue("64x64", FAtlasUtils::IsSourceCompatible(TSF_BGRA8, 64, 64, 4));
+
+							TArray<uint8> mip0, mip1;
+							mip0.SetNumZeroed(64 * 64 * 4);
+							mip1.SetNumZeroed(32 * 32 * 4);
+							uint8* mips[] = { mip0.GetData(), mip1.GetData() };
+							TArray64<uint8> tileData;
+							tileData.SetNumZeroed(5 * 8 * 4);
+							TestFalse("WriteTile", FAtlasUtils::WriteTile(mips, 64, FIntPoint(0, 0), tileData, 5, 8, 2));
+						});
+
+					It("will write the tile into every mip and wrap it into the padding", [this]()
+						{
+							TArray<uint8> mip0, mip1;
+							mip0.SetNumZeroed(32 * 32 * 4);
+							mip1.SetNumZeroed(16 * 16 * 4);
+							uint8* mips[] = { mip0.GetData(), mip1.GetData() };
+
+							// Left half red, right half blue
+							TArray64<uint8> tileData;
+							tileData.SetNumZeroed(8 * 8 * 4);
+							for (int y = 0; y < 8; ++y)
+							{
+								for (int x = 0; x < 8; ++x)
+								{
+									tileData[(y * 8 + x) * 4 + (x < 4 ? 2 : 0)] = 255;
+									tileData[(y * 8 + x) * 4 + 3] = 255;
+								}
+							}
+							if (!TestTrue("WriteTile", FAtlasUtils::WriteTile(mips, 32, FIntPoint(4, 4), tileData, 8, 8, 2))) { return; }
+							TestEqual("mip 0 tile red", mip0[((6 * 32) + 6) * 4 + 2], (uint8)255);
+							TestEqual("mip 0 padding wraps to blue", mip0[((6 * 32) + 5) * 4 + 0], (uint8)255);
+							TestEqual("mip 0 outside untouched", mip0[((6 * 32) + 3) * 4 + 3], (uint8)0);
+							TestEqual("mip 1 tile red", mip1[((3 * 16) + 3) * 4 + 2], (uint8)255);
+							TestEqual("mip 1 tile blue", mip1[((3 * 16) + 6) * 4 + 0], (uint8)255);
+						});
+				});
+
+			Describe("MergeSections", [this]()
+				{
+					BeforeEach([this]()
+						{
+							MeshDesc = FMeshDescription();
+							FStaticMeshAttributes(MeshDesc).Register();
+						});
+
+					It("will only fit sections that stay within one repeat of the texture", [this]()
+						{
+							const FPolygonGroupID inTile = AddQuad(TEXT("a"), FVector2f(2.0f, 5.0f), FVector2f(3.0f, 6.0f));
+							const FPolygonGroupID overTile = AddQuad(TEXT("b"), FVector2f(0.0f, 0.0f), FVector2f(2.0f, 1.0f));
+							TestTrue("inTile", FAtlasUtils::FitsInTile(MeshDesc, inTile));
+							TestFalse("overTile", FAtlasUtils::FitsInTile(MeshDesc, overTile));
+						});
+
+					It("will merge sections into one per page and remap their uvs", [this]()
+						{
+							const FPolygonGroupID a = AddQuad(TEXT("a"), FVector2f(2.0f, 5.0f), FVector2f(3.0f, 6.0f));
+							const FPolygonGroupID b = AddQuad(TEXT("b"), FVector2f(0.0f, 0.0f), FVector2f(1.0f, 1.0f));
+							AddQuad(TEXT("c"), FVector2f(0.0f, 0.0f), FVector2f(4.0f, 4.0f));
+							const FName pageSlotName(TEXT("Atlases/Atlas_0"));
+							TArray<FAtlasSectionMerge> merges;
+							merges.AddDefaulted(2);
+							merges[0].PolyGroup = a;
+							merges[0].Rect = FBox2f(FVector2f(0.0f, 0.0f), FVector2f(0.5f, 0.5f));
+							merges[0].PageSlotName = pageSlotName;
+							merges[1].PolyGroup = b;
+							merges[1].Rect = FBox2f(FVector2f(0.5f, 0.0f), FVector2f(1.0f, 0.5f));
+							merges[1].PageSlotName = pageSlotName;
+							FAtlasUtils::MergeSections(MeshDesc, merges);
+
+							TestEqual("sections", CountSections(), 2);
+							FStaticMeshAttributes staticMeshAttr(MeshDesc);
+							const TMeshAttributesRef<FPolygonGroupID, FName> polyGroupMaterial = staticMeshAttr.GetPolygonGroupMaterialSlotNames();
+							const TMeshAttributesRef<FVertexInstanceID, FVector2f> vertexInstanceAttrUV = staticMeshAttr.GetVertexInstanceUVs();
+							for (const FPolygonGroupID polyGroupID : MeshDesc.PolygonGroups().GetElementIDs())
+							{
+								if (polyGroupMaterial[polyGroupID] != pageSlotName) { continue; }
+								TestEqual("merged polygons", MeshDesc.GetNumPolygonGroupPolygons(polyGroupID), 2);
+								for (const FPolygonID polyID : MeshDesc.GetPolygonGroupPolygonIDs(polyGroupID))
+								{
+									FBox2f uvBounds(ForceInit);
+									for (const FVertexInstanceID vertInstID : MeshDesc.GetPolygonVertexInstanceIDs(polyID))
+									{
+										uvBounds += vertexInstanceAttrUV.Get(vertInstID, 0);
+									}
+									const bool matchesRect = merges.ContainsByPredicate([&](const FAtlasSectionMerge& merge)
+										{
+											return uvBounds.Min.Equals(merge.Rect.Min) && uvBounds.Max.Equals(merge.Rect.Max);
+										});
+									TestTrue("uvs fill a rect", matchesRect);
+								}
+							}
+						});
+				});
+		});
+}
@@ -22,6 +22,7 @@
 #include "Internationalization/Regex.h"
 #include "MeshAttributes.h"
 #include "MeshUtils.h"
+#include "AtlasUtils.h"
 #include "UObject/ConstructorHelpers.h"
 #include "AssetRegistryModule.h"
 #include "Internationalization/Regex.h"
@@ -33,6 +34,9 @@
 #include "SourceCoord.h"
 #include "IHL2Editor.h"
 #include "EntityEmitter.h"
+#include "Materials/MaterialInstanceConstant.h"
+#include "Engine/Texture2D.h"
+#include "VMTMaterial.h"
 
 DEFINE_LOG_CATEGORY(LogHL2BSPImporter);
 
@@ -59,6 +63,30 @@ bool FBSPImporter::Load()
 		UE_LOG(LogHL2BSPImporter, Error, TEXT("Failed to parse BSP"));
 		return false;
 	}
+
+	// Parse each texdata's material name once, faces and brush sides share them heavily
+	texdataMaterials.Empty(bspFile.m_Texdatas.size());
+	for (const Valve::BSP::texdata_t& bspTexData : bspFile.m_Texdatas)
+	{
+		const char* bspMaterialName = &bspFile.m_TexdataStringData[0] + bspFile.m_TexdataStringTable[bspTexData.m_NameStringTableID];
+		texdataMaterials.Add(FName(*ParseMaterialName(bspMaterialName)));
+	}
+
+	// Resolve every material the map uses in one asset registry query, rather than one per material as faces are built
+	TArray<FName> uniqueMaterials;
+	TArray<FString> uniqueMaterialPaths;
+	for (const FName material : texdataMaterials)
+	{
+		if (materialCache.Contains(material) || uniqueMaterials.Contains(material)) { continue; }
+		uniqueMaterials.Add(material);
+		uniqueMaterialPaths.Add(material.ToString());
+	}
+	TArray<UMaterialInterface*> resolvedMaterials;
+	IHL2Runtime::Get().TryResolveHL2Materials(uniqueMaterialPaths, resolvedMaterials);
+	for (int32 i = 0; i < uniqueMaterials.Num(); ++i)
+	{
+		materialCache.Add(uniqueMaterials[i], resolvedMaterials[i]);
+	}
 	return true;
 }
 
@@ -98,6 +126,7 @@ bool FBSPImporter::ImportGeometryToWorld(UWorld* targetWorld)
 
 	TArray<AStaticMeshActor*> staticMeshes;
 	RenderModelToActors(staticMeshes, 0);
+	InsertCellsToVBSPInfo(staticMeshes);
 	GEditor->SelectNone(false, true, false);
 	for (AStaticMeshActor* actor : staticMeshes)
 	{
@@ -130,73 +159,9 @@ bool FBSPImporter::ImportEntitiesToWorld(UWorld* targetWorld)
 	const FFolder entitiesFolder(TEXT("HL2Entities"));
 	UE_LOG(LogHL2BSPImporter, Log, TEXT("Importing entities..."));
 
-	// Read entities lump
-	const auto entityStrRaw = StringCast<TCHAR>(&bspFile.m_Entities[0], bspFile.m_Entities.size());
-	FString entityStr(entityStrRaw.Get());
-
-	// Parse into entity data
+	// Parse entities lump straight from its raw bytes into entity data
 	TArray<FHL2EntityData> entityDatas;
-	if (!FEntityParser::ParseEntities(entityStr, entityDatas)) { return false; }
-
-	// Parse static props
-	const static FName fnStaticProp(TEXT("prop_static"));
-	const static FName fnSolidity(TEXT("solidity"));
-	const static FName fnModel(TEXT("model"));
-	const static FName fnSkin(TEXT("skin"));
-	const static FName fnAngles(TEXT("angles"));
-	// TODO: Find a way to not have all these dumb loops
-	for (const Valve::BSP::StaticProp_v4_t staticProp : bspFile.m_Staticprops_v4)
-	{
-		FHL2EntityData entityData;
-		entityData.Classname = fnStaticProp;
-		entityData.Origin = FVector3f(staticProp.m_Origin(0, 0), staticProp.m_Origin(0, 1), staticProp.m_Origin(0, 2));
-		entityData.KeyValues[fnSolidity] = FString::FromInt((int)staticProp.m_Solid);
-		const char* modelStr = bspFile.m_StaticpropStringTable[staticProp.m_PropType].m_Str;
-		const auto& modelRaw = StringCast<TCHAR, 128>(modelStr);
-		entityData.KeyValues[fnModel] = FString(modelRaw.Length(), modelRaw.Get());
-		entityData.KeyValues[fnAngles] = FString::Printf(TEXT("%f %f %f"), staticProp.m_Angles(0, 0), staticProp.m_Angles(0, 1), staticProp.m_Angles(0, 2));
-		entityData.KeyValues[fnSkin] = FString::FromInt(staticProp.m_Skin);
-		entityDatas.Add(entityData);
-	}
-	for (const Valve::BSP::StaticProp_v5_t staticProp : bspFile.m_Staticprops_v5)
-	{
-		FHL2EntityData entityData;
-		entityData.Classname = fnStaticProp;
-		entityData.Origin = FVector3f(staticProp.m_Origin(0, 0), staticProp.m_Origin(0, 1), staticProp.m_Origin(0, 2));
-		entityData.KeyValues[fnSolidity] = FString::FromInt((int)staticProp.m_Solid);
-		const char* modelStr = bspFile.m_StaticpropStringTable[staticProp.m_PropType].m_Str;
-		const auto& modelRaw = StringCast<TCHAR, 128>(modelStr);
-		entityData.KeyValues[fnModel] = FString(modelRaw.Length(), modelRaw.Get());
-		entityData.KeyValues[fnAngles] = FString::Printf(TEXT("%f %f %f"), staticProp.m_Angles(0, 0), staticProp.m_Angles(0, 1), staticProp.m_Angles(0, 2));
-		entityData.KeyValues[fnSkin] = FString::FromInt(staticProp.m_Skin);
-		entityDatas.Add(entityData);
-	}
-	for (const Valve::BSP::StaticProp_v6_t staticProp : bspFile.m_Staticprops_v6)
-	{
-		FHL2EntityData entityData;
-		entityData.Classname = fnStaticProp;
-		entityData.Origin = FVector3f(staticProp.m_Origin(0, 0), staticProp.m_Origin(0, 1), staticProp.m_Origin(0, 2));
-		entityData.KeyValues.Add(fnSolidity, FString::FromInt((int)staticProp.m_Solid));
-		const char* modelStr = bspFile.m_StaticpropStringTable[staticProp.m_PropType].m_Str;
-		const auto& modelRaw = StringCast<TCHAR, 128>(modelStr);
-		entityData.KeyValues.Add(fnModel, FString(modelRaw.Length(), modelRaw.Get()));
-		entityData.KeyValues.Add(fnAngles, FString::Printf(TEXT("%f %f %f"), staticProp.m_Angles(0, 0), staticProp.m_Angles(0, 1), staticProp.m_Angles(0, 2)));
-		entityData.KeyValues.Add(fnSkin, FString::FromInt(staticProp.m_Skin));
-		entityDatas.Add(entityData);
-	}
-	for (const Valve::BSP::StaticProp_v10_t staticProp : bspFile.m_Staticprops_v10)
-	{
-		FHL2EntityData entityData;
-		entityData.Classname = fnStaticProp;
-		entityData.Origin = FVector3f(staticProp.m_Origin(0, 0), staticProp.m_Origin(0, 1), staticProp.m_Origin(0, 2));
-		entityData.KeyValues.Add(fnSolidity, FString::FromInt((int)staticProp.m_Solid));
-		const char* modelStr = bspFile.m_StaticpropStringTable[staticProp.m_PropType].m_Str;
-		const auto& modelRaw = StringCast<TCHAR, 128>(modelStr);
-		entityData.KeyValues.Add(fnModel, FString(modelRaw.Length(), modelRaw.Get()));
-		entityData.KeyValues.Add(fnAngles, FString::Printf(TEXT("%f %f %f"), staticProp.m_Angles(0, 0), staticProp.m_Angles(0, 1), staticProp.m_Angles(0, 2)));
-		entityData.KeyValues.Add(fnSkin, FString::FromInt(staticProp.m_Skin));
-		entityDatas.Add(entityData);
-	}
+	if (!FEntityParser::ParseEntities(bspFile.m_Entities.data(), (int32)bspFile.m_Entities.size(), entityDatas)) { return false; }
 
 	// Parse cubemaps
 	const FHL2EditorBSPConfig& bspConfig = IHL2Editor::Get().GetConfig().BSP;
@@ -214,10 +179,28 @@ bool FBSPImporter::ImportEntitiesToWorld(UWorld* targetWorld)
 		}
 	}
 
-	// Generate models
+	// Find which entities use each brush model
+	const static FName fnModel(TEXT("model"));
+	TMap<int, TArray<int>> modelUsers;
+	for (int i = 0; i < entityDatas.Num(); ++i)
+	{
+		FString model;
+		int modelIndex;
+		if (!entityDatas[i].TryGetString(fnModel, model) || !FEntityEmitter::TryParseBrushModelIndex(model, modelIndex)) { continue; }
+		if (modelIndex > 0 && modelIndex < (int)bspFile.m_Models.size())
+		{
+			modelUsers.FindOrAdd(modelIndex).Add(i);
+		}
+	}
+
+	// Generate models, building one mesh per unique geometry
 	TArray<UStaticMesh*> bspModels;
 	bspModels.Reserve(bspFile.m_Models.size());
 	bspModels.Add(nullptr); // brushes aren't going to reference the worldmodel
+	TMap<uint32, TArray<int>> signatureHashToModels;
+	TArray<TArray<int32>> modelSignatures;
+	modelSignatures.AddDefaulted(bspFile.m_Models.size());
+	int uniqueModelCount = 0;
 	for (int i = 1; i < bspFile.m_Models.size(); ++i)
 	{
 		const Valve::BSP::dmodel_t& bspModel = bspFile.m_Models[i];
@@ -228,16 +211,77 @@ bool FBSPImporter::ImportEntitiesToWorld(UWorld* targetWorld)
 		staticMeshAttr.Register();
 		staticMeshAttr.RegisterTriangleNormalAndTangentAttributes();
 		RenderFacesToMesh(faces, meshDesc, false);
+
+		// Models compiled with an origin brush are already local to their entity and pivot around it, so they enclose their origin and are left be.
+		// Everything else is in world space, so move it to be local to its rounded centre and move its entities to match.
+		const TArray<int>* users = modelUsers.Find(i);
+		const FBox3f modelBounds = GetModelBounds(bspModel, false);
+		const bool isLocal = !FVector3f(bspModel.m_Origin(0, 0), bspModel.m_Origin(0, 1), bspModel.m_Origin(0, 2)).IsNearlyZero() || modelBounds.ExpandBy(1.0f).IsInside(FVector3f::ZeroVector);
+		FVector3f anchor = FVector3f::ZeroVector;
+		if (!isLocal)
+		{
+			const FVector3f center = modelBounds.GetCenter();
+			anchor = FVector3f(FMath::RoundToFloat(center.X), FMath::RoundToFloat(center.Y), FMath::RoundToFloat(center.Z));
+			const FVector3f unrealAnchor = SourceToUnreal.Position(anchor);
+			TMeshAttributesRef<FVertexID, FVector3f> vertexAttrPosition = staticMeshAttr.GetVertexPositions();
+			for (const FVertexID vertID : meshDesc.Vertices().GetElementIDs())
+			{
+				vertexAttrPosition[vertID] -= unrealAnchor;
+			}
+			if (users != nullptr)
+			{
+				// Keep the origin keyvalue in step with the actor, for anything that reads it rather than the transform
+				const static FName fnOrigin(TEXT("origin"));
+				for (const int userIndex : *users)
+				{
+					FHL2EntityData& entityData = entityDatas[userIndex];
+					entityData.Origin += anchor;
+					entityData.KeyValues.Add(fnOrigin, FString::Printf(TEXT("%g %g %g"), entityData.Origin.X, entityData.Origin.Y, entityData.Origin.Z));
+					entityData.ResetTypedValue(fnOrigin);
+				}
+			}
+		}
+
+		// Reuse the mesh of an earlier model with identical local geometry
+		TArray<int32>& signature = modelSignatures[i];
+		const uint32 signatureHash = BuildGeometrySignature(meshDesc, signature);
+		TArray<int>& sameHashModels = signatureHashToModels.FindOrAdd(signatureHash);
+		const int* duplicateOf = sameHashModels.FindByPredicate([&](const int otherIndex) { return modelSignatures[otherIndex] == signature; });
+		if (duplicateOf != nullptr)
+		{
+			bspModels.Add(bspModels[*duplicateOf]);
+			signature.Empty();
+			continue;
+		}
+		sameHashModels.Add(i);
+		++uniqueModelCount;
+
 		FStaticMeshOperations::ComputeTangentsAndNormals(meshDesc, EComputeNTBsFlags::Normals & EComputeNTBsFlags::Tangents);
 		meshDesc.TriangulateMesh();
 		const int lightmapResolution = 128;
 		bspModels.Add(RenderMeshToStaticMesh(meshDesc, FString::Printf(TEXT("Models/Model_%d"), i), lightmapResolution));
 	}
+	UE_LOG(LogHL2BSPImporter, Log, TEXT("Built %d unique meshes for %d brush models"), uniqueModelCount, (int)bspFile.m_Models.size() - 1);
 
-	// Convert into actors
-	FScopedSlowTask progress(entityDatas.Num(), LOCTEXT("MapEntitiesImporting", "Importing map entities..."));
+	// Convert into actors, each one is spawned and then finalised in a second pass
+	const int entityCount = entityDatas.Num() + (int)bspFile.m_Staticprops.size();
+	FScopedSlowTask progress(entityCount * 2, LOCTEXT("MapEntitiesImporting", "Importing map entities..."));
 	FEntityEmitter emitter(targetWorld, bspFile, bspModels, vbspInfo);
+	emitter.BeginBulkSpawn();
 	emitter.GenerateActors(entityDatas, &progress);
+	emitter.GenerateStaticProps(&progress);
+	if (bspConfig.EmitWorldLights)
+	{
+		emitter.GenerateWorldLights();
+	}
+	emitter.EndBulkSpawn(&progress);
+
+	// Index entities by cluster
+	if (vbspInfo != nullptr && !bspConfig.Portable)
+	{
+		vbspInfo->RebuildEntityIndex();
+		vbspInfo->MarkPackageDirty();
+	}
 
 	return true;
 }
@@ -256,12 +300,15 @@ void FBSPImporter::RenderModelToActors(TArray<AStaticMeshActor*>& out, uint32 mo
 	const int cellMinY = FMath::FloorToInt(bspBounds.Min.Y / bspConfig.CellSize);
 	const int cellMaxY = FMath::CeilToInt(bspBounds.Max.Y / bspConfig.CellSize);
 
-	FScopedSlowTask progress((cellMaxX - cellMinX + 1) * (cellMaxY - cellMinY + 1) + 33, LOCTEXT("MapGeometryImporting", "Importing map geometry..."));
+	FScopedSlowTask progress((cellMaxX - cellMinX + 1) * (cellMaxY - cellMinY + 1) + 34, LOCTEXT("MapGeometryImporting", "Importing map geometry..."));
 	progress.MakeDialog();
 
 	// Render out VBSPInfo
-	//progress.EnterProgressFrame(1.0f, LOCTEXT("MapGeometryImporting_VBSPINFO", "Generating VBSPInfo..."));
-	//RenderTreeToVBSPInfo(bspModel.m_Headnode);
+	progress.EnterProgressFrame(1.0f, LOCTEXT("MapGeometryImporting_VBSPINFO", "Generating VBSPInfo..."));
+	if (!bspConfig.Portable)
+	{
+		RenderTreeToVBSPInfo(bspModel.m_Headnode);
+	}
 
 	// Gather all faces and displacements from tree
 	progress.EnterProgressFrame(1.0f, LOCTEXT("MapGeometryImporting_GATHER", "Gathering faces and displacements..."));
@@ -345,6 +392,10 @@ void FBSPImporter::RenderModelToActors(TArray<AStaticMeshActor*>& out, uint32 mo
 				}
 			}
 
+			// Merge sections of cells that are over the draw call budget
+			progress.EnterProgressFrame(1.0f, LOCTEXT("MapGeometryImporting_BUDGET", "Merging cell sections..."));
+			ApplyDrawCallBudget(cellMeshes);
+
 			// Generate static mesh actors for cells
 			for (int cellIndex = 0; cellIndex < cellCount; ++cellIndex)
 			{
@@ -360,8 +411,7 @@ void FBSPImporter::RenderModelToActors(TArray<AStaticMeshActor*>& out, uint32 mo
 					AStaticMeshActor* staticMeshActor = RenderMeshToActor(cellMeshDesc, FString::Printf(TEXT("Cells/Cell_%d"), cellIndex), lightmapResolutions[cellIndex]);
 					staticMeshActor->SetActorLabel(FString::Printf(TEXT("Cell_%d_%d"), cellX, cellY));
 					out.Add(staticMeshActor);
-
-					// TODO: Insert to VBSPInfo
+					if (vbspInfo != nullptr) { vbspInfo->BrushGeometry.Add(staticMeshActor); }
 				}
 			}
 		}
@@ -388,6 +438,7 @@ void FBSPImporter::RenderModelToActors(TArray<AStaticMeshActor*>& out, uint32 mo
 			AStaticMeshActor* staticMeshActor = RenderMeshToActor(meshDesc, TEXT("WorldGeometry"), lightmapResolution);
 			staticMeshActor->SetActorLabel(TEXT("WorldGeometry"));
 			out.Add(staticMeshActor);
+			if (vbspInfo != nullptr) { vbspInfo->BrushGeometry.Add(staticMeshActor); }
 		}
 	}
 
@@ -449,8 +500,6 @@ void FBSPImporter::RenderModelToActors(TArray<AStaticMeshActor*>& out, uint32 mo
 						AStaticMeshActor* staticMeshActor = RenderMeshToActor(cellMeshDesc, FString::Printf(TEXT("Cells/DisplacementCell_%d"), cellIndex++), lightmapResolution);
 						staticMeshActor->SetActorLabel(FString::Printf(TEXT("DisplacementCell_%d_%d"), cellX, cellY));
 						out.Add(staticMeshActor);
-
-						// TODO: Insert to VBSPInfo
 					}
 				}
 			}
@@ -511,6 +560,7 @@ void FBSPImporter::RenderModelToActors(TArray<AStaticMeshActor*>& out, uint32 mo
 		staticMeshActor->PostEditChange();
 		staticMeshActor->MarkPackageDirty();
 		out.Add(staticMeshActor);
+		if (vbspInfo != nullptr) { vbspInfo->BrushGeometry.Add(staticMeshActor); }
 	}
 }
 
@@ -540,8 +590,9 @@ UStaticMesh* FBSPImporter::RenderMeshToStaticMesh(const FMeshDescription& meshDe
 	for (const FPolygonGroupID& polyGroupID : worldModelMesh->PolygonGroups().GetElementIDs())
 	{
 		const FName materialName = importedMaterialSlotNameAttr[polyGroupID];
+		UMaterialInterface* const* atlasMaterial = atlasMaterials.Find(materialName);
 		const FStaticMaterial staticMaterial(
-			Cast<UMaterialInterface>(IHL2Runtime::Get().TryResolveHL2Material(materialName.ToString())),
+			atlasMaterial != nullptr ? *atlasMaterial : ResolveMaterial(materialName),
 			materialName,
 			materialName
 		);
@@ -581,6 +632,292 @@ AStaticMeshActor* FBSPImporter::RenderMeshToActor(const FMeshDescription& meshDe
 	return staticMeshActor;
 }
 
+// Atlases carry their own mip chain, built tile by tile. The gutter around each tile halves with every mip,
+// so it starts wide enough to still be two texels at the smallest mip, and tiles are aligned so they stay on whole texels
+constexpr int atlasMipCount = 4;
+constexpr int atlasMipAlignment = 1 << (atlasMipCount - 1);
+constexpr int atlasPadding = 2 * atlasMipAlignment;
+const FName fnBaseTexture(TEXT("basetexture"));
+
+void FBSPImporter::ApplyDrawCallBudget(TArray<FMeshDescription>& cellMeshes)
+{
+	const FHL2EditorBSPConfig& bspConfig = IHL2Editor::Get().GetConfig().BSP;
+
+	// Report sections per cell
+	int totalSections = 0, maxSections = 0, overBudgetCells = 0;
+	for (int cellIndex = 0; cellIndex < cellMeshes.Num(); ++cellIndex)
+	{
+		const FMeshDescription& cellMeshDesc = cellMeshes[cellIndex];
+		if (cellMeshDesc.Triangles().Num() == 0) { continue; }
+		int sections = 0;
+		for (const FPolygonGroupID polyGroupID : cellMeshDesc.PolygonGroups().GetElementIDs())
+		{
+			if (cellMeshDesc.GetNumPolygonGroupPolygons(polyGroupID) > 0) { ++sections; }
+		}
+		UE_LOG(LogHL2BSPImporter, Verbose, TEXT("Cell %d has %d sections"), cellIndex, sections);
+		totalSections += sections;
+		maxSections = FMath::Max(maxSections, sections);
+		if (bspConfig.MaxSectionsPerCell > 0 && sections > bspConfig.MaxSectionsPerCell) { ++overBudgetCells; }
+	}
+	UE_LOG(LogHL2BSPImporter, Log, TEXT("Cells have %d sections in total, %d at most, %d cells over budget of %d"), totalSections, maxSections, overBudgetCells, bspConfig.MaxSectionsPerCell);
+	if (overBudgetCells == 0) { return; }
+
+	// A material can be atlased if it's configured as compatible and has an uncompressed base texture that fits in an atlas page
+	// With no materials configured, any material can be, as merging already requires everything but the base texture to match
+	struct FAtlasCandidate
+	{
+		UMaterialInstanceConstant* Material = nullptr;
+		UTexture2D* BaseTexture = nullptr;
+		int Bucket = -1;
+		int Page = -1;
+		FBox2f Rect = FBox2f(ForceInit);
+	};
+	TArray<FAtlasCandidate> candidates;
+	TMap<FName, int> materialToCandidate;
+	TMap<FString, int> bucketMap;
+
+	// Materials can only share an atlas if everything but the base texture matches, as the atlas material copies the rest from one of them
+	const auto makeBucketKey = [&](const UMaterialInstanceConstant* material) -> FString
+	{
+		TArray<FString> parts;
+		for (const FScalarParameterValue& param : material->ScalarParameterValues)
+		{
+			parts.Add(FString::Printf(TEXT("s:%s=%g"), *param.ParameterInfo.ToString(), param.ParameterValue));
+		}
+		for (const FVectorParameterValue& param : material->VectorParameterValues)
+		{
+			parts.Add(FString::Printf(TEXT("v:%s=%s"), *param.ParameterInfo.ToString(), *param.ParameterValue.ToString()));
+		}
+		for (const FTextureParameterValue& param : material->TextureParameterValues)
+		{
+			if (param.ParameterInfo.Name == fnBaseTexture) { continue; }
+			parts.Add(FString::Printf(TEXT("t:%s=%s"), *param.ParameterInfo.ToString(), *GetPathNameSafe(param.ParameterValue)));
+		}
+		for (const FStaticSwitchParameter& param : material->GetStaticParameters().StaticSwitchParameters)
+		{
+			parts.Add(FString::Printf(TEXT("w:%s=%d"), *param.ParameterInfo.ToString(), param.Value ? 1 : 0));
+		}
+		parts.Sort();
+		const UVMTMaterial* vmtMaterial = Cast<UVMTMaterial>(material);
+		return FString::Printf(TEXT("%s|%d|%d|%s|%s|%s"),
+			*GetPathNameSafe(material->Parent),
+			(int32)material->GetBlendMode(),
+			material->IsTwoSided() ? 1 : 0,
+			*GetPathNameSafe(material->PhysMaterial),
+			vmtMaterial != nullptr ? *vmtMaterial->vmtSurfaceProp : TEXT(""),
+			*FString::Join(parts, TEXT(";"))
+		);
+	};
+
+	const auto findCandidate = [&](const FName materialName) -> int
+	{
+		const int* existing = materialToCandidate.Find(materialName);
+		if (existing != nullptr) { return *existing; }
+		int& result = materialToCandidate.Add(materialName, -1);
+		const FString materialNameStr = materialName.ToString();
+		if (bspConfig.AtlasCompatibleMaterials.Num() > 0 && !bspConfig.AtlasCompatibleMaterials.ContainsByPredicate([&](const FString& pattern) { return materialNameStr.MatchesWildcard(pattern); })) { return -1; }
+		UMaterialInstanceConstant* material = Cast<UMaterialInstanceConstant>(ResolveMaterial(materialName));
+		if (material == nullptr || material->Parent == nullptr) { return -1; }
+		UTexture* baseTexture;
+		if (!material->GetTextureParameterValue(FMaterialParameterInfo(fnBaseTexture), baseTexture, true)) { return -1; }
+		UTexture2D* baseTexture2D = Cast<UTexture2D>(baseTexture);
+		if (baseTexture2D == nullptr) { return -1; }
+		const FTextureSource& source = baseTexture2D->Source;
+		if (!FAtlasUtils::IsSourceCompatible(source.GetFormat(), source.GetSizeX(), source.GetSizeY(), atlasMipCount))
+		{
+			UE_LOG(LogHL2BSPImporter, Verbose, TEXT("Not atlasing '%s', its base texture is not BGRA8 with dimensions divisible by %d"), *materialNameStr, atlasMipAlignment);
+			return -1;
+		}
+		if (source.GetSizeX() + atlasPadding * 2 > bspConfig.AtlasSize || source.GetSizeY() + atlasPadding * 2 > bspConfig.AtlasSize) { return -1; }
+		FAtlasCandidate candidate;
+		candidate.Material = material;
+		candidate.BaseTexture = baseTexture2D;
+		candidate.Bucket = bucketMap.FindOrAdd(makeBucketKey(material), bucketMap.Num());
+		result = candidates.Add(candidate);
+		return result;
+	};
+
+	// Plan which sections of each over budget cell get merged, largest buckets first
+	struct FCellMerge
+	{
+		int CellIndex;
+		TArray<FPolygonGroupID> PolyGroups;
+		TArray<int> Candidates;
+	};
+	TArray<FCellMerge> merges;
+	TArray<bool> candidateUsed;
+	for (int cellIndex = 0; cellIndex < cellMeshes.Num(); ++cellIndex)
+	{
+		FMeshDescription& cellMeshDesc = cellMeshes[cellIndex];
+		FStaticMeshAttributes staticMeshAttr(cellMeshDesc);
+		const TMeshAttributesRef<FPolygonGroupID, FName> polyGroupMaterial = staticMeshAttr.GetPolygonGroupMaterialSlotNames();
+
+		int sections = 0;
+		for (const FPolygonGroupID polyGroupID : cellMeshDesc.PolygonGroups().GetElementIDs())
+		{
+			if (cellMeshDesc.GetNumPolygonGroupPolygons(polyGroupID) > 0) { ++sections; }
+		}
+		if (sections <= bspConfig.MaxSectionsPerCell) { continue; }
+
+		TMap<int, TArray<FPolygonGroupID>> polyGroupsByBucket;
+		for (const FPolygonGroupID polyGroupID : cellMeshDesc.PolygonGroups().GetElementIDs())
+		{
+			if (cellMeshDesc.GetNumPolygonGroupPolygons(polyGroupID) == 0) { continue; }
+			const int candidateIndex = findCandidate(polyGroupMaterial[polyGroupID]);
+			if (candidateIndex < 0) { continue; }
+
+			// Only sections whose polygons each span a single texture repeat can be remapped into an atlas
+			if (FAtlasUtils::FitsInTile(cellMeshDesc, polyGroupID))
+			{
+				polyGroupsByBucket.FindOrAdd(candidates[candidateIndex].Bucket).Add(polyGroupID);
+			}
+		}
+
+		TArray<TArray<FPolygonGroupID>> buckets;
+		polyGroupsByBucket.GenerateValueArray(buckets);
+		buckets.Sort([](const TArray<FPolygonGroupID>& a, const TArray<FPolygonGroupID>& b) { return a.Num() > b.Num(); });
+		for (const TArray<FPolygonGroupID>& bucket : buckets)
+		{
+			if (sections <= bspConfig.MaxSectionsPerCell || bucket.Num() < 2) { break; }
+			FCellMerge& merge = merges.AddDefaulted_GetRef();
+			merge.CellIndex = cellIndex;
+			merge.PolyGroups = bucket;
+			for (const FPolygonGroupID polyGroupID : bucket)
+			{
+				merge.Candidates.Add(materialToCandidate[polyGroupMaterial[polyGroupID]]);
+			}
+			sections -= bucket.Num() - 1;
+		}
+	}
+	if (merges.Num() == 0) { return; }
+
+	// Pack the base textures of every merged material into atlas pages, one set of pages per bucket
+	candidateUsed.Init(false, candidates.Num());
+	for (const FCellMerge& merge : merges)
+	{
+		for (const int candidateIndex : merge.Candidates)
+		{
+			candidateUsed[candidateIndex] = true;
+		}
+	}
+	TArray<int> packedCandidates;
+	TArray<FAtlasTile> tiles;
+	for (int candidateIndex = 0; candidateIndex < candidates.Num(); ++candidateIndex)
+	{
+		if (!candidateUsed[candidateIndex]) { continue; }
+		FAtlasTile& tile = tiles.AddDefaulted_GetRef();
+		tile.Size = FIntPoint(candidates[candidateIndex].BaseTexture->Source.GetSizeX(), candidates[candidateIndex].BaseTexture->Source.GetSizeY());
+		tile.Bucket = candidates[candidateIndex].Bucket;
+		packedCandidates.Add(candidateIndex);
+	}
+	const TArray<int> pageBuckets = FAtlasUtils::PackTiles(tiles, bspConfig.AtlasSize, atlasPadding);
+	struct FAtlasPage
+	{
+		TArray<int> Candidates;
+		FName SlotName;
+	};
+	TArray<FAtlasPage> pages;
+	pages.SetNum(pageBuckets.Num());
+	for (int pageIndex = 0; pageIndex < pages.Num(); ++pageIndex)
+	{
+		pages[pageIndex].SlotName = FName(*FString::Printf(TEXT("Atlases/Atlas_%d"), pageIndex));
+	}
+	for (int tileIndex = 0; tileIndex < tiles.Num(); ++tileIndex)
+	{
+		FAtlasCandidate& candidate = candidates[packedCandidates[tileIndex]];
+		candidate.Page = tiles[tileIndex].Page;
+		candidate.Rect = tiles[tileIndex].Rect;
+		pages[candidate.Page].Candidates.Add(packedCandidates[tileIndex]);
+	}
+
+	// Render each page to a texture and a material instance of the bucket's shader
+	// Every material on a page has the same parameters apart from the base texture, so any of them can serve as the parent
+	for (const FAtlasPage& page : pages)
+	{
+		TArray<UTexture2D*> textures;
+		TArray<FBox2f> rects;
+		for (const int candidateIndex : page.Candidates)
+		{
+			textures.Add(candidates[candidateIndex].BaseTexture);
+			rects.Add(candidates[candidateIndex].Rect);
+		}
+		atlasMaterials.Add(page.SlotName, RenderAtlasPage(page.SlotName, candidates[page.Candidates[0]].Material, textures, rects));
+	}
+
+	// Remap UVs into the atlas and move polygons into one section per page
+	for (const FCellMerge& merge : merges)
+	{
+		TArray<FAtlasSectionMerge> sectionMerges;
+		for (int i = 0; i < merge.PolyGroups.Num(); ++i)
+		{
+			const FAtlasCandidate& candidate = candidates[merge.Candidates[i]];
+			FAtlasSectionMerge& sectionMerge = sectionMerges.AddDefaulted_GetRef();
+			sectionMerge.PolyGroup = merge.PolyGroups[i];
+			sectionMerge.Rect = candidate.Rect;
+			sectionMerge.PageSlotName = pages[candidate.Page].SlotName;
+		}
+		FAtlasUtils::MergeSections(cellMeshes[merge.CellIndex], sectionMerges);
+	}
+	UE_LOG(LogHL2BSPImporter, Log, TEXT("Merged %d groups of cell sections into %d atlases"), merges.Num(), pages.Num());
+}
+
+UMaterialInstanceConstant* FBSPImporter::RenderAtlasPage(const FName slotName, UMaterialInstanceConstant* parentMaterial, TArrayView<UTexture2D* const> textures, TArrayView<const FBox2f> rects)
+{
+	const FHL2EditorBSPConfig& bspConfig = IHL2Editor::Get().GetConfig().BSP;
+
+	// Reuses the asset from a previous import of this map, so that reimporting doesn't orphan or clash with it
+	const auto findOrCreateAsset = [](UClass* assetClass, const FString& packageName, bool& outCreated) -> UObject*
+	{
+		const FString assetName = FPaths::GetBaseFilename(packageName);
+		UObject* existing = StaticLoadObject(assetClass, nullptr, *(packageName + TEXT(".") + assetName), nullptr, LOAD_NoWarn | LOAD_Quiet);
+		outCreated = existing == nullptr;
+		if (existing != nullptr) { return existing; }
+		return NewObject<UObject>(CreatePackage(*packageName), assetClass, FName(*assetName), RF_Public | RF_Standalone);
+	};
+
+	const FString packageName = TEXT("/Game/hl2/maps") / mapName / slotName.ToString();
+	bool textureCreated;
+	UTexture2D* atlasTexture = CastChecked<UTexture2D>(findOrCreateAsset(UTexture2D::StaticClass(), packageName + TEXT("_Texture"), textureCreated));
+	if (!textureCreated) { atlasTexture->ReleaseResource(); }
+	atlasTexture->Source.Init(bspConfig.AtlasSize, bspConfig.AtlasSize, 1, atlasMipCount, TSF_BGRA8);
+	atlasTexture->MipGenSettings = TMGS_LeaveExistingMips;
+	TArray<uint8*, TInlineAllocator<atlasMipCount>> atlasMips;
+	for (int mip = 0; mip < atlasMipCount; ++mip)
+	{
+		atlasMips.Add(atlasTexture->Source.LockMip(mip));
+		FMemory::Memzero(atlasMips[mip], atlasTexture->Source.CalcMipSize(mip));
+	}
+	for (int i = 0; i < textures.Num(); ++i)
+	{
+		TArray64<uint8> sourceData;
+		textures[i]->Source.GetMipData(sourceData, 0);
+		const FIntPoint dest(
+			FMath::RoundToInt(rects[i].Min.X * bspConfig.AtlasSize) - atlasPadding,
+			FMath::RoundToInt(rects[i].Min.Y * bspConfig.AtlasSize) - atlasPadding
+		);
+		const bool written = FAtlasUtils::WriteTile(atlasMips, bspConfig.AtlasSize, dest, MoveTemp(sourceData), textures[i]->Source.GetSizeX(), textures[i]->Source.GetSizeY(), atlasPadding);
+		ensureMsgf(written, TEXT("'%s' was accepted for atlasing but could not be written"), *GetPathNameSafe(textures[i]));
+	}
+	for (int mip = 0; mip < atlasMipCount; ++mip)
+	{
+		atlasTexture->Source.UnlockMip(mip);
+	}
+	atlasTexture->SRGB = textures[0]->SRGB;
+	atlasTexture->PostEditChange();
+	if (textureCreated) { FAssetRegistryModule::AssetCreated(atlasTexture); }
+	atlasTexture->MarkPackageDirty();
+
+	bool materialCreated;
+	UMaterialInstanceConstant* atlasMaterial = CastChecked<UMaterialInstanceConstant>(findOrCreateAsset(UMaterialInstanceConstant::StaticClass(), packageName, materialCreated));
+	if (!materialCreated) { atlasMaterial->ClearParameterValuesEditorOnly(); }
+	atlasMaterial->SetParentEditorOnly(parentMaterial);
+	atlasMaterial->SetTextureParameterValueEditorOnly(FMaterialParameterInfo(fnBaseTexture), atlasTexture);
+	atlasMaterial->PostEditChange();
+	if (materialCreated) { FAssetRegistryModule::AssetCreated(atlasMaterial); }
+	atlasMaterial->MarkPackageDirty();
+	return atlasMaterial;
+}
+
 void FBSPImporter::GatherBrushes(uint32 nodeIndex, TArray<uint16>& out)
 {
 	const Valve::BSP::snode_t& node = bspFile.m_Nodes[nodeIndex];
@@ -698,12 +1035,12 @@ void FBSPImporter::RenderFacesToMesh(const TArray<uint16>& faceIndices, FMeshDes
 		const Valve::BSP::texinfo_t& bspTexInfo = bspFile.m_Texinfos[bspFace.m_Texinfo];
 		const uint16 texDataIndex = (uint16)bspTexInfo.m_Texdata;
 		const Valve::BSP::texdata_t& bspTexData = bspFile.m_Texdatas[bspTexInfo.m_Texdata];
-		const char* bspMaterialName = &bspFile.m_TexdataStringData[0] + bspFile.m_TexdataStringTable[bspTexData.m_NameStringTableID];
-		FString parsedMaterialName = ParseMaterialName(bspMaterialName);
+		const FName material = texdataMaterials[bspTexInfo.m_Texdata];
 
-		const bool isSkybox = parsedMaterialName.Equals(TEXT("tools/toolsskybox"), ESearchCase::IgnoreCase) || parsedMaterialName.Equals(TEXT("tools/toolsskybox2d"), ESearchCase::IgnoreCase);
+		const static FName fnToolsSkybox(TEXT("tools/toolsskybox"));
+		const static FName fnToolsSkybox2D(TEXT("tools/toolsskybox2d"));
+		const bool isSkybox = material == fnToolsSkybox || material == fnToolsSkybox2D;
 		if (isSkybox != skyboxFilter) { continue; }
-		FName material(*parsedMaterialName);
 
 		// Create polygroup if needed (we make one per material/texdata)
 		FPolygonGroupID polyGroup;
@@ -869,13 +1206,11 @@ void FBSPImporter::RenderBrushesToMesh(const TArray<uint16>& brushIndices, FMesh
 					if (bspTexInfo.m_Texdata >= 0 && !(bspTexInfo.m_Flags & rejectedSurfFlags))
 					{
 						const Valve::BSP::texdata_t& bspTexData = bspFile.m_Texdatas[bspTexInfo.m_Texdata];
-						const char* bspMaterialName = &bspFile.m_TexdataStringData[0] + bspFile.m_TexdataStringTable[bspTexData.m_NameStringTableID];
-						FString parsedMaterialName = ParseMaterialName(bspMaterialName);
 						side.TextureU = FVector4f(bspTexInfo.m_TextureVecs[0][0], bspTexInfo.m_TextureVecs[0][1], bspTexInfo.m_TextureVecs[0][2], bspTexInfo.m_TextureVecs[0][3]);
 						side.TextureV = FVector4f(bspTexInfo.m_TextureVecs[1][0], bspTexInfo.m_TextureVecs[1][1], bspTexInfo.m_TextureVecs[1][2], bspTexInfo.m_TextureVecs[1][3]);
 						side.TextureW = (uint16)bspTexData.m_Width;
 						side.TextureH = (uint16)bspTexData.m_Height;
-						side.Material = FName(*parsedMaterialName);
+						side.Material = texdataMaterials[bspTexInfo.m_Texdata];
 						side.EmitGeometry = true;
 					}
 				}
@@ -915,9 +1250,7 @@ void FBSPImporter::RenderDisplacementsToMesh(const TArray<uint16>& displacements
 		const Valve::BSP::texinfo_t& bspTexInfo = bspFile.m_Texinfos[bspFace.m_Texinfo];
 		const uint16 texDataIndex = (uint16)bspTexInfo.m_Texdata;
 		const Valve::BSP::texdata_t& bspTexData = bspFile.m_Texdatas[bspTexInfo.m_Texdata];
-		const char* bspMaterialName = &bspFile.m_TexdataStringData[0] + bspFile.m_TexdataStringTable[bspTexData.m_NameStringTableID];
-		FString parsedMaterialName = ParseMaterialName(bspMaterialName);
-		FName material(*parsedMaterialName);
+		const FName material = texdataMaterials[bspTexInfo.m_Texdata];
 
 		// Create a unique poly group for us
 		const FPolygonGroupID polyGroupID = meshDesc.CreatePolygonGroup();
@@ -1057,136 +1390,155 @@ void FBSPImporter::RenderDisplacementsToMesh(const TArray<uint16>& displacements
 void FBSPImporter::RenderTreeToVBSPInfo(uint32 nodeIndex)
 {
 	vbspInfo = world->SpawnActor<AVBSPInfo>();
+	vbspInfo->SetActorLabel(TEXT("VBSPInfo"));
+
+	TMap<int32, int32> leafMap;
 
-	TMap<uint32, int> nodeMap;
-	// TMap<uint32, int> leafMap;
-	TMap<int16, int> clusterMap;
+	// Copy brushes as-is so that leaf brush indices can be used directly, converting each side plane to unreal space
+	vbspInfo->Brushes.Reserve((int32)bspFile.m_Brushes.size());
+	vbspInfo->BrushSides.Reserve((int32)bspFile.m_Brushsides.size());
+	for (const Valve::BSP::dbrush_t& bspBrush : bspFile.m_Brushes)
+	{
+		FVBSPBrush newBrush;
+		newBrush.Contents = bspBrush.m_Contents;
+		newBrush.Sides.Offset = vbspInfo->BrushSides.Num();
+		newBrush.Sides.Count = bspBrush.m_Numsides;
+		for (int32 i = 0; i < bspBrush.m_Numsides; ++i)
+		{
+			const Valve::BSP::dbrushside_t& bspSide = bspFile.m_Brushsides[bspBrush.m_Firstside + i];
+			FVBSPBrushSide newSide;
+			newSide.Plane = ValveToUnrealPlane(bspFile.m_Planes[bspSide.m_Planenum]);
+			newSide.Bevel = bspSide.m_Bevel != 0;
+			vbspInfo->BrushSides.Add(newSide);
+		}
+		vbspInfo->Brushes.Add(newBrush);
+	}
+
+	// Resolves a vbsp leaf child to our own child index, emitting the leaf if needed
+	// Node children are left as 0 and filled in once the child node has been emitted
+	const auto resolveChild = [&](int32 bspChild) -> int32
+	{
+		if (bspChild >= 0) { return 0; }
+		const int32 bspLeafIndex = -1 - bspChild;
+		const int32* existingLeafIndex = leafMap.Find(bspLeafIndex);
+		if (existingLeafIndex != nullptr) { return -(1 + *existingLeafIndex); }
+		const Valve::BSP::dleaf_t& bspLeaf = bspFile.m_Leaves[bspLeafIndex];
+		FVBSPLeaf newLeaf;
+		newLeaf.Solid = (bspLeaf.m_Contents & Valve::BSP::CONTENTS_SOLID) != 0;
+		newLeaf.Cluster = bspLeaf.m_Cluster;
+		newLeaf.Brushes.Offset = vbspInfo->LeafBrushPool.Num();
+		newLeaf.Brushes.Count = bspLeaf.m_Numleafbrushes;
+		for (int32 i = 0; i < bspLeaf.m_Numleafbrushes; ++i)
+		{
+			vbspInfo->LeafBrushPool.Add(bspFile.m_Leafbrushes[bspLeaf.m_Firstleafbrush + i]);
+		}
+		const int32 newLeafIndex = vbspInfo->Leaves.Add(newLeaf);
+		leafMap.Add(bspLeafIndex, newLeafIndex);
+		return -(1 + newLeafIndex);
+	};
 
+	// Explore the node hierarchy depth-first, front child first, so that the front child of a node is usually adjacent to it in memory
 	struct ExploreState
 	{
 		uint32 NodeIndex;
-		uint32 ParentNodeIndex;
-		bool IsLeft;
-		ExploreState(uint32 nodeIndex, uint32 parentNodeIndex, bool isLeft)
-			: NodeIndex(nodeIndex), ParentNodeIndex(parentNodeIndex), IsLeft(isLeft)
-		{ }
-		ExploreState()
-			: ExploreState(0, 0, false)
-		{ }
+		int32 ParentIndex;
+		bool IsFront;
 	};
-
-	// Explore the node hierarchy
 	TArray<ExploreState> exploreStack;
-	exploreStack.Push(ExploreState(nodeIndex, nodeIndex, false));
+	exploreStack.Push({ nodeIndex, INDEX_NONE, false });
 	while (exploreStack.Num() > 0)
 	{
-		const ExploreState state = exploreStack.Pop();
+		const ExploreState state = exploreStack.Pop(false);
 		const Valve::BSP::snode_t& bspNode = bspFile.m_Nodes[state.NodeIndex];
-		FVBSPNode newNode;
-		newNode.Plane = ValveToUnrealPlane(bspFile.m_Planes[bspNode.m_PlaneNum]);
-		const int newNodeIndex = vbspInfo->Nodes.Add(newNode);
-		nodeMap.Add(state.NodeIndex, newNodeIndex);
-		if (state.ParentNodeIndex != state.NodeIndex)
+		const int32 newNodeIndex = vbspInfo->Nodes.AddDefaulted();
+		if (state.ParentIndex != INDEX_NONE)
 		{
-			FVBSPNode& parentNode = vbspInfo->Nodes[nodeMap[state.ParentNodeIndex]];
-			if (state.IsLeft)
-			{
-				parentNode.Left = newNodeIndex;
-			}
-			else
-			{
-				parentNode.Right = newNodeIndex;
-			}
+			FVBSPNode& parentNode = vbspInfo->Nodes[state.ParentIndex];
+			(state.IsFront ? parentNode.Front : parentNode.Back) = newNodeIndex;
 		}
+		FVBSPNode& newNode = vbspInfo->Nodes[newNodeIndex];
+		newNode.Plane = ValveToUnrealPlane(bspFile.m_Planes[bspNode.m_PlaneNum]);
+		newNode.Front = resolveChild(bspNode.m_Children[0]);
+		newNode.Back = resolveChild(bspNode.m_Children[1]);
 
-		// Check left
-		if (bspNode.m_Children[0] < 0)
+		// Push back first so that front is popped (and therefore emitted) first
+		if (bspNode.m_Children[1] >= 0)
 		{
-			// Left is leaf
-			const Valve::BSP::dleaf_t& bspLeaf = bspFile.m_Leaves[1 - bspNode.m_Children[0]];
-			FVBSPLeaf newLeaf;
-			newLeaf.Solid = (bspLeaf.m_Contents & Valve::BSP::CONTENTS_SOLID) != 0;
-			int newLeafIndex = vbspInfo->Leaves.Num();
-			if (bspLeaf.m_Cluster >= 0)
-			{
-				int* tmpCluster = clusterMap.Find(bspLeaf.m_Cluster);
-				if (tmpCluster != nullptr)
-				{
-					newLeaf.Cluster = *tmpCluster;
-				}
-				else
-				{
-					FVBSPCluster newCluster;
-					newCluster.Leaves.Add(newLeafIndex);
-					newLeaf.Cluster = vbspInfo->Clusters.Add(newCluster);
-					clusterMap.Add(bspLeaf.m_Cluster, newLeaf.Cluster);
-				}
-			}
-			else
-			{
-				newLeaf.Cluster = -1;
-			}
-			check(vbspInfo->Leaves.Add(newLeaf) == newLeafIndex);
-			vbspInfo->Nodes[newNodeIndex].Left = -(1 + newLeafIndex);
+			exploreStack.Push({ (uint32)bspNode.m_Children[1], newNodeIndex, false });
 		}
-		else
+		if (bspNode.m_Children[0] >= 0)
 		{
-			// Left is node
-			exploreStack.Push(ExploreState((uint32)bspNode.m_Children[0], state.NodeIndex, true));
+			exploreStack.Push({ (uint32)bspNode.m_Children[0], newNodeIndex, true });
 		}
+	}
 
-		// Check right
-		if (bspNode.m_Children[1] < 0)
-		{
-			// Right is leaf
-			const Valve::BSP::dleaf_t& bspLeaf = bspFile.m_Leaves[1 - bspNode.m_Children[1]];
-			FVBSPLeaf newLeaf;
-			newLeaf.Solid = (bspLeaf.m_Contents & Valve::BSP::CONTENTS_SOLID) != 0;
-			int newLeafIndex = vbspInfo->Leaves.Num();
-			if (bspLeaf.m_Cluster >= 0)
-			{
-				int* tmpCluster = clusterMap.Find(bspLeaf.m_Cluster);
-				if (tmpCluster != nullptr)
-				{
-					newLeaf.Cluster = *tmpCluster;
-				}
-				else
-				{
-					FVBSPCluster newCluster;
-					newCluster.Leaves.Add(newLeafIndex);
-					newLeaf.Cluster = vbspInfo->Clusters.Add(newCluster);
-					clusterMap.Add(bspLeaf.m_Cluster, newLeaf.Cluster);
-				}
-			}
-			else
-			{
-				newLeaf.Cluster = -1;
-			}
-			check(vbspInfo->Leaves.Add(newLeaf) == newLeafIndex);
-			vbspInfo->Nodes[newNodeIndex].Right = -(1 + newLeafIndex);
-		}
-		else
-		{
-			// Right is node
-			exploreStack.Push(ExploreState((uint32)bspNode.m_Children[1], state.NodeIndex, false));
-		}
+	// Gather leaves per cluster
+	const int32 numClusters = (int32)bspFile.m_Visibility.size();
+	TArray<TArray<int32>> clusterLeaves;
+	clusterLeaves.SetNum(numClusters);
+	for (int32 leafIndex = 0; leafIndex < vbspInfo->Leaves.Num(); ++leafIndex)
+	{
+		const int32 cluster = vbspInfo->Leaves[leafIndex].Cluster;
+		if (cluster < 0) { continue; }
+		if (cluster >= clusterLeaves.Num()) { clusterLeaves.SetNum(cluster + 1); }
+		clusterLeaves[cluster].Add(leafIndex);
 	}
 
-	// Parse vis info
-	for (const auto& pair : clusterMap)
+	// Pack clusters into flat pools
+	vbspInfo->Clusters.SetNum(clusterLeaves.Num());
+	for (int32 clusterIndex = 0; clusterIndex < clusterLeaves.Num(); ++clusterIndex)
 	{
-		const std::vector<int>& bspVisibleSet = bspFile.m_Visibility[pair.Key];
-		FVBSPCluster& cluster = vbspInfo->Clusters[pair.Value];
-		for (const int otherCluster : bspVisibleSet)
+		FVBSPCluster& cluster = vbspInfo->Clusters[clusterIndex];
+		cluster.Leaves.Offset = vbspInfo->LeafPool.Num();
+		cluster.Leaves.Count = clusterLeaves[clusterIndex].Num();
+		vbspInfo->LeafPool.Append(clusterLeaves[clusterIndex]);
+		cluster.VisibleClusters.Offset = vbspInfo->VisibilityPool.Num();
+		if (clusterIndex < numClusters)
 		{
-			cluster.VisibleClusters.Add(otherCluster);
+			const std::vector<int>& bspVisibleSet = bspFile.m_Visibility[clusterIndex];
+			vbspInfo->VisibilityPool.Append(bspVisibleSet.data(), (int32)bspVisibleSet.size());
 		}
+		cluster.VisibleClusters.Count = vbspInfo->VisibilityPool.Num() - cluster.VisibleClusters.Offset;
 	}
 
+	// Precompute leaf bounds for coherent leaf lookups
+	vbspInfo->BuildLeafBoundingPlanes();
+
 	vbspInfo->PostEditChange();
 	vbspInfo->MarkPackageDirty();
 }
 
+void FBSPImporter::InsertCellsToVBSPInfo(const TArray<AStaticMeshActor*>& cells)
+{
+	if (vbspInfo == nullptr) { return; }
+
+	// Insert each cell into every cluster that has a leaf touching it, found by walking the tree with the cell bounds
+	TArray<TArray<AStaticMeshActor*>> cellsByCluster;
+	TArray<TArray<ABaseEntity*>> entitiesByCluster;
+	cellsByCluster.SetNum(vbspInfo->Clusters.Num());
+	entitiesByCluster.SetNum(vbspInfo->Clusters.Num());
+	TArray<int32> leaves;
+	TBitArray<> cellClusters(false, vbspInfo->Clusters.Num());
+	for (AStaticMeshActor* cell : cells)
+	{
+		vbspInfo->FindLeavesInBox(FBox3f(cell->GetComponentsBoundingBox(true)), leaves);
+		for (const int32 leafIndex : leaves)
+		{
+			const int32 cluster = vbspInfo->Leaves[leafIndex].Cluster;
+			if (!cellClusters.IsValidIndex(cluster) || cellClusters[cluster]) { continue; }
+			cellClusters[cluster] = true;
+			cellsByCluster[cluster].Add(cell);
+		}
+		for (const int32 leafIndex : leaves)
+		{
+			const int32 cluster = vbspInfo->Leaves[leafIndex].Cluster;
+			if (cellClusters.IsValidIndex(cluster)) { cellClusters[cluster] = false; }
+		}
+	}
+	vbspInfo->SetClusterActors(cellsByCluster, entitiesByCluster);
+	vbspInfo->MarkPackageDirty();
+}
+
 float FBSPImporter::FindFaceArea(const Valve::BSP::dface_t& bspFace, bool unrealCoordSpace)
 {
 	TArray<FVector3f> vertices;
@@ -1236,6 +1588,15 @@ FBox3f FBSPImporter::GetNodeBounds(const Valve::BSP::snode_t& node, bool unrealC
 	return FBox3f(min, max);
 }
 
+UMaterialInterface* FBSPImporter::ResolveMaterial(const FName materialName)
+{
+	UMaterialInterface** cachedMaterial = materialCache.Find(materialName);
+	if (cachedMaterial != nullptr) { return *cachedMaterial; }
+	UMaterialInterface* material = Cast<UMaterialInterface>(IHL2Runtime::Get().TryResolveHL2Material(materialName.ToString()));
+	materialCache.Add(materialName, material);
+	return material;
+}
+
 FString FBSPImporter::ParseMaterialName(const char* bspMaterialName)
 {
 	// It might be something like "brick/brick06c" which is fine
@@ -1263,6 +1624,84 @@ FString FBSPImporter::ParseMaterialName(const char* bspMaterialName)
 	return bspMaterialNameAsStr;
 }
 
+uint32 FBSPImporter::BuildGeometrySignature(const FMeshDescription& meshDesc, TArray<int32>& outSignature)
+{
+	FStaticMeshConstAttributes staticMeshAttr(meshDesc);
+	const TMeshAttributesConstRef<FVertexID, FVector3f> vertexAttrPosition = staticMeshAttr.GetVertexPositions();
+	const TMeshAttributesConstRef<FVertexInstanceID, FVector2f> vertexInstanceAttrUV = staticMeshAttr.GetVertexInstanceUVs();
+	const TMeshAttributesConstRef<FPolygonGroupID, FName> polyGroupMaterial = staticMeshAttr.GetPolygonGroupMaterialSlotNames();
+	constexpr float positionQuantum = 16.0f;
+	constexpr float uvQuantum = 1024.0f;
+
+	// One record per polygon: material, vertex count, then quantised position and uv per vertex
+	TArray<TArray<int32>> polyRecords;
+	polyRecords.Reserve(meshDesc.Polygons().Num());
+	for (const FPolygonID polyID : meshDesc.Polygons().GetElementIDs())
+	{
+		const TArrayView<const FVertexInstanceID> vertInstIDs = meshDesc.GetPolygonVertexInstanceIDs(polyID);
+
+		// Texture repeats are interchangeable, so only keep the uv offset within the first repeat
+		FVector2f uvMin(TNumericLimits<float>::Max());
+		for (const FVertexInstanceID vertInstID : vertInstIDs)
+		{
+			uvMin = FVector2f::Min(uvMin, vertexInstanceAttrUV.Get(vertInstID, 0));
+		}
+		const FVector2f uvTile(FMath::FloorToFloat(uvMin.X), FMath::FloorToFloat(uvMin.Y));
+
+		TArray<FIntVector> positions;
+		TArray<FIntPoint> uvs;
+		positions.Reserve(vertInstIDs.Num());
+		uvs.Reserve(vertInstIDs.Num());
+		int firstVert = 0;
+		for (const FVertexInstanceID vertInstID : vertInstIDs)
+		{
+			const FVector3f pos = vertexAttrPosition[meshDesc.GetVertexInstanceVertex(vertInstID)] * positionQuantum;
+			const FVector2f uv = (vertexInstanceAttrUV.Get(vertInstID, 0) - uvTile) * uvQuantum;
+			positions.Add(FIntVector(FMath::RoundToInt(pos.X), FMath::RoundToInt(pos.Y), FMath::RoundToInt(pos.Z)));
+			uvs.Add(FIntPoint(FMath::RoundToInt(uv.X), FMath::RoundToInt(uv.Y)));
+			const FIntVector& first = positions[firstVert];
+			const FIntVector& last = positions.Last();
+			if (last.X < first.X || (last.X == first.X && (last.Y < first.Y || (last.Y == first.Y && last.Z < first.Z))))
+			{
+				firstVert = positions.Num() - 1;
+			}
+		}
+
+		// Start the winding at the smallest position so the same polygon always produces the same record
+		TArray<int32>& record = polyRecords.AddDefaulted_GetRef();
+		record.Reserve(2 + positions.Num() * 5);
+		record.Add((int32)GetTypeHash(polyGroupMaterial[meshDesc.GetPolygonPolygonGroup(polyID)]));
+		record.Add(positions.Num());
+		for (int i = 0; i < positions.Num(); ++i)
+		{
+			const int vert = (firstVert + i) % positions.Num();
+			record.Add(positions[vert].X);
+			record.Add(positions[vert].Y);
+			record.Add(positions[vert].Z);
+			record.Add(uvs[vert].X);
+			record.Add(uvs[vert].Y);
+		}
+	}
+
+	// Sort records so the order faces were compiled in doesn't matter
+	polyRecords.Sort([](const TArray<int32>& a, const TArray<int32>& b)
+	{
+		const int num = FMath::Min(a.Num(), b.Num());
+		for (int i = 0; i < num; ++i)
+		{
+			if (a[i] != b[i]) { return a[i] < b[i]; }
+		}
+		return a.Num() < b.Num();
+	});
+
+	outSignature.Empty();
+	for (const TArray<int32>& record : polyRecords)
+	{
+		outSignature.Append(record);
+	}
+	return FCrc::MemCrc32(outSignature.GetData(), outSignature.Num() * outSignature.GetTypeSize());
+}
+
 bool FBSPImporter::SharesSmoothingGroup(uint16 groupA, uint16 groupB)
 {
 	for (uint16 i = 0; i < 16; ++i)
@@ -10,6 +10,9 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogHL2BSPImporter, Log, All);
 
+class UMaterialInstanceConstant;
+class UTexture2D;
+
 class FBSPImporter
 {
 private:
@@ -21,6 +24,9 @@ private:
 	FString mapName;
 	UWorld* world;
 	AVBSPInfo* vbspInfo;
+	TMap<FName, UMaterialInterface*> atlasMaterials;
+	TArray<FName> texdataMaterials;
+	TMap<FName, UMaterialInterface*> materialCache;
 
 public:
 
@@ -56,6 +62,12 @@ private:
 	UStaticMesh* RenderMeshToStaticMesh(const FMeshDescription& meshDesc, const FString& assetName, int lightmapResolution);
 
 	AStaticMeshActor* RenderMeshToActor(const FMeshDescription& meshDesc, const FString& assetName, int lightmapResolution);
+
+	/* Reports sections per cell and merges compatible sections of cells over the budget into texture atlases. */
+	void ApplyDrawCallBudget(TArray<FMeshDescription>& cellMeshes);
+
+	/** Renders the textures into the given rects of an atlas texture, and creates a material instance of the parent that uses it as its base texture. */
+	UMaterialInstanceConstant* RenderAtlasPage(const FName slotName, UMaterialInstanceConstant* parentMaterial, TArrayView<UTexture2D* const> textures, TArrayView<const FBox2f> rects);
 	
 	void RenderFacesToMesh(const TArray<uint16>& faceIndices, FMeshDescription& meshDesc, bool skyboxFilter);
 
@@ -65,13 +77,21 @@ private:
 	
 	void RenderTreeToVBSPInfo(uint32 nodeIndex);
 
+	void InsertCellsToVBSPInfo(const TArray<AStaticMeshActor*>& cells);
+
 	float FindFaceArea(const Valve::BSP::dface_t& bspFace, bool unrealCoordSpace = true);
 
 	static FBox3f GetModelBounds(const Valve::BSP::dmodel_t& model, bool unrealCoordSpace = true);
 
 	static FBox3f GetNodeBounds(const Valve::BSP::snode_t& node, bool unrealCoordSpace = true);
 
+	/* Resolves a material by its HL2 path, caching the result (including failures) for the lifetime of the importer. */
+	UMaterialInterface* ResolveMaterial(const FName materialName);
+
 	static FString ParseMaterialName(const char* bspMaterialName);
+
+	/* Builds an order independent signature of the quantised positions, materials and uvs of a mesh, returning its hash. */
+	static uint32 BuildGeometrySignature(const FMeshDescription& meshDesc, TArray<int32>& outSignature);
 	
 	static bool SharesSmoothingGroup(uint16 groupA, uint16 groupB);
 
@@ -9,11 +9,19 @@
 #include "IHL2Runtime.h"
 #include "SourceCoord.h"
 #include "AssetRegistryModule.h"
-#include "Internationalization/Regex.h"
 #include "HL2EntityDataUtils.h"
+#include "HL2ModelData.h"
 #include "Animation/SkeletalMeshActor.h"
 #include "Engine/DirectionalLight.h"
 #include "Components/DirectionalLightComponent.h"
+#include "Engine/PointLight.h"
+#include "Engine/SpotLight.h"
+#include "Components/PointLightComponent.h"
+#include "Components/SpotLightComponent.h"
+#include "Engine/Selection.h"
+#include "ScopedTransaction.h"
+#include "BSPImporter.h"
+#include "Editor.h"
 
 const FName fnLightEnv(TEXT("light_environment"));
 const FName fnLight(TEXT("light"));
@@ -23,6 +31,8 @@ const FName fnPropStatic(TEXT("prop_static"));
 const FName fnPropDynamic(TEXT("prop_dynamic"));
 const FName fnFuncBrush(TEXT("func_brush"));
 const FName fnModel(TEXT("model"));
+const FName fnSolidity(TEXT("solidity"));
+const FName fnSkin(TEXT("skin"));
 const FName fnAngles(TEXT("angles"));
 const FName fnPitch(TEXT("pitch"));
 const FName fnLightColor(TEXT("_light"));
@@ -30,10 +40,59 @@ const FName fnAmbientLightColor(TEXT("_ambient"));
 const FName fnAssetRegistry(TEXT("AssetRegistry"));
 const FName fnEntities(TEXT("Entities"));
 const FName fnHL2Entities(TEXT("HL2Entities"));
+const FName fnLights(TEXT("Lights"));
+const FName fnDefaultAnim(TEXT("DefaultAnim"));
+const FName fnRandomAnimation(TEXT("RandomAnimation"));
+const FName fnOnAnimationBegun(TEXT("OnAnimationBegun"));
+const FName fnOnAnimationDone(TEXT("OnAnimationDone"));
+
+// Inputs of prop_dynamic and prop_physics that need a skeletal mesh to have any effect
+static const FName animationInputs[] =
+{
+	FName(TEXT("SetAnimation")),
+	FName(TEXT("SetAnimationNoReset")),
+	FName(TEXT("SetDefaultAnimation")),
+	FName(TEXT("SetPlaybackRate")),
+	FName(TEXT("SetBodyGroup")),
+	FName(TEXT("BecomeRagdoll")),
+};
+
+// Intensity below which a worldlight with no explicit radius is cut off, as in ComputeLightRadius of the Source SDK
+// Designers usually halve light intensity in HDR, so the HDR cutoff is halved to keep the radius consistent
+static constexpr float WorldLightCutoffLDR = 0.03f;
+static constexpr float WorldLightCutoffHDR = 0.015f;
+
+// Radius, in Source units, that ComputeLightRadius gives to lights with no attenuation, which would otherwise be infinite
+static constexpr float WorldLightInfiniteRadius = 2000.0f;
+
+static bool ShouldUseHDRWorldLights(const Valve::BSPFile& bspFile)
+{
+	if (bspFile.m_WorldlightsHDR.empty()) { return false; }
+	if (bspFile.m_Worldlights.empty()) { return true; }
+	return IHL2Editor::Get().GetConfig().BSP.PreferHDRWorldLights;
+}
+
+static FIntVector GetWorldLightKey(const FVector3f& origin)
+{
+	return FIntVector(FMath::RoundToInt(origin.X), FMath::RoundToInt(origin.Y), FMath::RoundToInt(origin.Z));
+}
 
 FEntityEmitter::FEntityEmitter(UWorld* world, const Valve::BSPFile& bspFile, const TArray<UStaticMesh*>& bspModels, AVBSPInfo* vbspInfo)
-	: world(world), bspFile(bspFile), bspModels(bspModels), vbspInfo(vbspInfo)
+	: world(world), bspFile(bspFile), bspModels(bspModels), vbspInfo(vbspInfo),
+	worldLights(ShouldUseHDRWorldLights(bspFile) ? bspFile.m_WorldlightsHDR : bspFile.m_Worldlights),
+	worldLightsAreHDR(ShouldUseHDRWorldLights(bspFile)),
+	bulkSpawning(false), previousTemporaryCachingMode(false)
 {
+	// Index point and spot worldlights by origin so light entities can find their compiled counterpart
+	worldLightsByOrigin.Reserve((int)worldLights.size());
+	for (int i = 0; i < (int)worldLights.size(); ++i)
+	{
+		const Valve::BSP::dworldlight_t& worldLight = worldLights[i];
+		if (worldLight.m_Type != Valve::BSP::emit_point && worldLight.m_Type != Valve::BSP::emit_spotlight) { continue; }
+		worldLightsByOrigin.Add(GetWorldLightKey(FVector3f(worldLight.m_Origin(0, 0), worldLight.m_Origin(0, 1), worldLight.m_Origin(0, 2))), i);
+	}
+	claimedWorldLights.Init(false, (int)worldLights.size());
+
 	// TODO: Figure out how to wrap methods into TFunction without using lambdas
 	portableEntityImporters.Add(fnPropPhysics, [&](const FHL2EntityData& entityData) { return ImportPortableProp(entityData); });
 	portableEntityImporters.Add(fnPropStatic, [&](const FHL2EntityData& entityData) { return ImportPortableProp(entityData); });
@@ -44,18 +103,78 @@ FEntityEmitter::FEntityEmitter(UWorld* world, const Valve::BSPFile& bspFile, con
 	portableEntityImporters.Add(fnLightSpot, [&](const FHL2EntityData& entityData) { return ImportPortableLight(entityData); });
 }
 
+FEntityEmitter::~FEntityEmitter()
+{
+	// Never leave actors half constructed
+	if (bulkSpawning)
+	{
+		EndBulkSpawn();
+	}
+}
+
+void FEntityEmitter::BeginBulkSpawn()
+{
+	check(!bulkSpawning);
+	bulkSpawning = true;
+	bulkTransaction = MakeUnique<FScopedTransaction>(NSLOCTEXT("HL2Importer", "ImportMapEntities", "Import Map Entities"));
+	importedActors.Empty();
+
+	// Selection change notifications are held until the batch ends
+	GEditor->GetSelectedActors()->BeginBatchSelectOperation();
+
+	// Every blueprint class lookup would otherwise rebuild the registry's class hierarchy
+	IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(fnAssetRegistry).Get();
+	previousTemporaryCachingMode = assetRegistry.GetTemporaryCachingMode();
+	assetRegistry.SetTemporaryCachingMode(true);
+}
+
+void FEntityEmitter::EndBulkSpawn(FScopedSlowTask* progress)
+{
+	check(bulkSpawning);
+
+	if (IHL2Editor::Get().GetConfig().BSP.ResolveLogicOutputTargets)
+	{
+		ResolveLogicOutputTargets();
+	}
+
+	// Construction scripts run once per entity here, with all keyvalues already in place
+	for (const FPendingEntity& pendingEntity : pendingEntities)
+	{
+		if (progress != nullptr) { progress->EnterProgressFrame(); }
+		FinishEntity(pendingEntity);
+	}
+	pendingEntities.Empty();
+
+	IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(fnAssetRegistry).Get();
+	assetRegistry.SetTemporaryCachingMode(previousTemporaryCachingMode);
+
+	// Select the imported actors within the batch, so the editor sees a single selection change
+	USelection* selectedActors = GEditor->GetSelectedActors();
+	GEditor->SelectNone(false, true, false);
+	for (AActor* actor : importedActors)
+	{
+		if (IsValid(actor)) { GEditor->SelectActor(actor, true, false); }
+	}
+	importedActors.Empty();
+	selectedActors->EndBatchSelectOperation(false);
+	GEditor->NoteSelectionChange();
+
+	bulkTransaction.Reset();
+	bulkSpawning = false;
+}
+
 void FEntityEmitter::GenerateActors(const TArrayView<FHL2EntityData>& entityDatas, FScopedSlowTask* progress)
 {
 	const FHL2EditorBSPConfig& bspConfig = IHL2Editor::Get().GetConfig().BSP;
+	if (bspConfig.Portable) { GatherAnimatedTargets(entityDatas); }
 
 	const FFolder entitiesFolder(bspConfig.Portable ? fnEntities : fnHL2Entities);
 	FActorFolders& folders = FActorFolders::Get();
 	folders.CreateFolder(*world, entitiesFolder);
 
-	GEditor->SelectNone(false, true, false);
-
 	bool importedLightEnv = false;
 	importCountMap.Empty();
+	claimedWorldLights.Init(false, (int)worldLights.size());
 	for (const FHL2EntityData& entityData : entityDatas)
 	{
 		progress->EnterProgressFrame();
@@ -69,7 +188,8 @@ void FEntityEmitter::GenerateActors(const TArrayView<FHL2EntityData>& entityData
 			if (actor != nullptr)
 			{
 				if (entityData.Classname == fnLightEnv) { importedLightEnv = true; }
-				GEditor->SelectActor(actor, true, false, true, false);
+				actor->SetFolderPath(entitiesFolder.GetPath());
+				if (bulkSpawning) { importedActors.Add(actor); }
 			}
 		}
 		else
@@ -77,7 +197,8 @@ void FEntityEmitter::GenerateActors(const TArrayView<FHL2EntityData>& entityData
 			ABaseEntity* entity = ImportEntityToWorld(entityData);
 			if (entity != nullptr)
 			{
-				GEditor->SelectActor(entity, true, false, true, false);
+				entity->SetFolderPath(entitiesFolder.GetPath());
+				if (bulkSpawning) { importedActors.Add(entity); }
 				if (entityData.Classname == fnLightEnv)
 				{
 					importedLightEnv = true;
@@ -85,57 +206,264 @@ void FEntityEmitter::GenerateActors(const TArrayView<FHL2EntityData>& entityData
 			}
 		}
 	}
+}
 
-	folders.SetSelectedFolderPath(entitiesFolder);
-	GEditor->SelectNone(false, true, false);
+void FEntityEmitter::ResolveLogicOutputTargets()
+{
+	// Gather every entity spawned so far, finished or still deferred
+	TArray<ABaseEntity*> entities = spawnedEntities;
+	for (const FPendingEntity& pendingEntity : pendingEntities)
+	{
+		entities.Add(pendingEntity.Entity);
+	}
+
+	// Index them the same way targetnames are matched at runtime, by targetname or classname
+	TMap<FName, TArray<ABaseEntity*>> entitiesByName;
+	for (ABaseEntity* entity : entities)
+	{
+		if (!entity->TargetName.IsNone())
+		{
+			entitiesByName.FindOrAdd(entity->TargetName).Add(entity);
+		}
+		if (!entity->EntityData.Classname.IsNone() && entity->EntityData.Classname != entity->TargetName)
+		{
+			entitiesByName.FindOrAdd(entity->EntityData.Classname).Add(entity);
+		}
+	}
+
+	int resolvedCount = 0;
+	int outputCount = 0;
+	for (ABaseEntity* entity : entities)
+	{
+		for (FEntityLogicOutput& logicOutput : entity->EntityData.LogicOutputs)
+		{
+			++outputCount;
+			logicOutput.ResolvedTargets.Empty();
+			logicOutput.TargetsResolved = false;
+
+			// Special targetnames depend on the IO chain and wildcards are left to the runtime index
+			FString targetName = logicOutput.TargetName.ToString();
+			if (targetName.StartsWith(TEXT("!")) || targetName.EndsWith(TEXT("*"))) { continue; }
+
+			// Names that match nothing here may still be spawned at runtime
+			const TArray<ABaseEntity*>* targets = entitiesByName.Find(logicOutput.TargetName);
+			if (targets == nullptr) { continue; }
+			logicOutput.ResolvedTargets.Reserve(targets->Num());
+			for (ABaseEntity* target : *targets)
+			{
+				logicOutput.ResolvedTargets.Add(target);
+			}
+			logicOutput.TargetsResolved = true;
+			++resolvedCount;
+		}
+		entity->ResetLogicOutputs();
+	}
+	UE_LOG(LogHL2BSPImporter, Log, TEXT("Resolved targets of %d of %d logic outputs at import time"), resolvedCount, outputCount);
 }
 
-ABaseEntity* FEntityEmitter::ImportEntityToWorld(const FHL2EntityData& entityData)
+bool FEntityEmitter::TryParseBrushModelIndex(const FString& model, int& outModelIndex)
 {
-	// Resolve blueprint
-	const FString assetPath = IHL2Runtime::Get().GetHL2EntityBasePath() + entityData.Classname.ToString() + TEXT(".") + entityData.Classname.ToString();
+	// Brush models are referenced as "*N"
+	if (model.Len() < 2 || model[0] != TEXT('*')) { return false; }
+	int modelIndex = 0;
+	for (int i = 1; i < model.Len(); ++i)
+	{
+		if (!FChar::IsDigit(model[i])) { return false; }
+		modelIndex = modelIndex * 10 + (model[i] - TEXT('0'));
+	}
+	outModelIndex = modelIndex;
+	return true;
+}
+
+UClass* FEntityEmitter::ResolveEntityClass(const FName classname)
+{
+	UClass** cachedClass = entityClassCache.Find(classname);
+	if (cachedClass != nullptr) { return *cachedClass; }
+	UClass*& entityClass = entityClassCache.Add(classname, nullptr);
+
+	const FString assetPath = IHL2Runtime::Get().GetHL2EntityBasePath() + classname.ToString() + TEXT(".") + classname.ToString();
 	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
 	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
 	FAssetData assetData = assetRegistry.GetAssetByObjectPath(FName(*assetPath));
-	if (!assetData.IsValid()) { return false; }
+	if (!assetData.IsValid()) { return nullptr; }
 	UBlueprint* blueprint = CastChecked<UBlueprint>(assetData.GetAsset());
+	entityClass = blueprint->GeneratedClass;
+	return entityClass;
+}
+
+UStaticMesh* FEntityEmitter::ResolveStaticProp(const FString& model)
+{
+	UStaticMesh** cachedStaticMesh = staticPropCache.Find(model);
+	if (cachedStaticMesh != nullptr) { return *cachedStaticMesh; }
+	UStaticMesh* staticMesh = IHL2Runtime::Get().TryResolveHL2StaticProp(model);
+	if (staticMesh != nullptr)
+	{
+		// The base mesh shows every bodygroup at once, so props start out on the default variant if one was baked
+		const UHL2ModelData* modelData = staticMesh->GetAssetUserData<UHL2ModelData>();
+		if (modelData != nullptr) { staticMesh = modelData->GetDefaultBakedVariant(staticMesh); }
+	}
+	staticPropCache.Add(model, staticMesh);
+	return staticMesh;
+}
+
+USkeletalMesh* FEntityEmitter::ResolveAnimatedProp(const FString& model)
+{
+	USkeletalMesh** cachedSkeletalMesh = animatedPropCache.Find(model);
+	if (cachedSkeletalMesh != nullptr) { return *cachedSkeletalMesh; }
+	USkeletalMesh* skeletalMesh = IHL2Runtime::Get().TryResolveHL2AnimatedProp(model);
+	animatedPropCache.Add(model, skeletalMesh);
+	return skeletalMesh;
+}
+
+UStaticMesh* FEntityEmitter::ResolveRigidProp(const FString& model)
+{
+	UStaticMesh** cachedStaticMesh = rigidPropCache.Find(model);
+	if (cachedStaticMesh != nullptr) { return *cachedStaticMesh; }
+	UStaticMesh* staticMesh = IHL2Runtime::Get().TryResolveHL2RigidProp(model);
+	rigidPropCache.Add(model, staticMesh);
+	return staticMesh;
+}
+
+void FEntityEmitter::GatherAnimatedTargets(const TArrayView<FHL2EntityData>& entityDatas)
+{
+	animatedTargetNames.Empty();
+	animatedTargetPrefixes.Empty();
+	for (const FHL2EntityData& entityData : entityDatas)
+	{
+		for (const FEntityLogicOutput& logicOutput : entityData.LogicOutputs)
+		{
+			bool isAnimationInput = false;
+			for (const FName animationInput : animationInputs)
+			{
+				if (logicOutput.InputName == animationInput)
+				{
+					isAnimationInput = true;
+					break;
+				}
+			}
+			if (!isAnimationInput) { continue; }
+			FString targetName = logicOutput.TargetName.ToString();
+			if (targetName.EndsWith(TEXT("*")))
+			{
+				targetName.LeftChopInline(1);
+				animatedTargetPrefixes.Add(targetName);
+			}
+			else
+			{
+				animatedTargetNames.Add(logicOutput.TargetName);
+			}
+		}
+	}
+}
+
+bool FEntityEmitter::IsNeverAnimated(const FHL2EntityData& entityData) const
+{
+	if (!entityData.GetString(fnDefaultAnim).IsEmpty()) { return false; }
+	if (entityData.GetInt(fnRandomAnimation) != 0) { return false; }
+	for (const FEntityLogicOutput& logicOutput : entityData.LogicOutputs)
+	{
+		if (logicOutput.OutputName == fnOnAnimationBegun || logicOutput.OutputName == fnOnAnimationDone) { return false; }
+	}
+	if (entityData.Targetname.IsEmpty()) { return true; }
+	if (animatedTargetNames.Contains(FName(*entityData.Targetname))) { return false; }
+	for (const FString& prefix : animatedTargetPrefixes)
+	{
+		if (entityData.Targetname.StartsWith(prefix)) { return false; }
+	}
+	return true;
+}
+
+ABaseEntity* FEntityEmitter::ImportEntityToWorld(const FHL2EntityData& entityData)
+{
+	// Resolve blueprint
+	UClass* entityClass = ResolveEntityClass(entityData.Classname);
+	if (entityClass == nullptr) { return nullptr; }
 
 	// Setup transform
 	FTransform3f transform = FTransform3f::Identity;
 	transform.SetLocation(SourceToUnreal.Position(entityData.Origin));
 
-	// Spawn the entity
-	ABaseEntity* entity = world->SpawnActor<ABaseEntity>(blueprint->GeneratedClass, FTransform(transform));
+	// Spawn the entity, construction is deferred until its keyvalues are in place
+	FPendingEntity pendingEntity;
+	pendingEntity.Transform = FTransform(transform);
+	ABaseEntity* entity = world->SpawnActorDeferred<ABaseEntity>(entityClass, pendingEntity.Transform);
 	if (entity == nullptr) { return nullptr; }
+	pendingEntity.Entity = entity;
 
 	// Set brush model on it
 	FString model;
 	if (entityData.TryGetString(fnModel, model))
 	{
-		static const FRegexPattern patternWorldModel(TEXT("^\\*([0-9]+)$"));
-		FRegexMatcher matchWorldModel(patternWorldModel, model);
-		if (matchWorldModel.FindNext())
+		int modelIndex;
+		if (TryParseBrushModelIndex(model, modelIndex))
 		{
-			int modelIndex = FCString::Atoi(*matchWorldModel.GetCaptureGroup(1));
 			check(bspModels.IsValidIndex(modelIndex));
 			entity->WorldModel = bspModels[modelIndex];
 		}
 	}
 
-	// Run ctor on the entity
 	entity->EntityData = entityData;
 	entity->VBSPInfo = vbspInfo;
 	if (!entityData.Targetname.IsEmpty())
 	{
 		entity->SetActorLabel(entityData.Targetname);
-		entity->TargetName = FName(*entityData.Targetname);
+		entity->SetTargetName(FName(*entityData.Targetname));
+	}
+	if (entityData.Classname == fnLight || entityData.Classname == fnLightSpot)
+	{
+		pendingEntity.WorldLight = ClaimWorldLight(entityData);
+	}
+	QueueEntity(pendingEntity);
+
+	return entity;
+}
+
+void FEntityEmitter::QueueEntity(const FPendingEntity& pendingEntity)
+{
+	if (bulkSpawning)
+	{
+		pendingEntities.Add(pendingEntity);
+	}
+	else
+	{
+		FinishEntity(pendingEntity);
+	}
+}
+
+void FEntityEmitter::FinishEntity(const FPendingEntity& pendingEntity)
+{
+	ABaseEntity* entity = pendingEntity.Entity;
+	spawnedEntities.Add(entity);
+
+	// Run ctor on the entity
+	entity->FinishSpawning(pendingEntity.Transform);
+
+	// Components are created by the construction script, so anything applied to them has to wait until now
+	if (pendingEntity.WorldLight != nullptr)
+	{
+		TInlineComponentArray<ULocalLightComponent*> lightComponents(entity);
+		for (ULocalLightComponent* lightComponent : lightComponents)
+		{
+			ApplyWorldLight(lightComponent, *pendingEntity.WorldLight);
+		}
+	}
+	if (pendingEntity.StaticProp != nullptr)
+	{
+		ApplyDefaultBodygroupVariant(entity);
+		ApplyStaticPropCullDistance(entity, *pendingEntity.StaticProp);
 	}
-	entity->RerunConstructionScripts();
 	entity->ResetLogicOutputs();
-	entity->PostEditChange();
 	entity->MarkPackageDirty();
+}
 
-	return entity;
+void FEntityEmitter::FinishActor(AActor* actor) const
+{
+	// Construction already ran at spawn, in bulk mode the per actor edit notification is just overhead
+	if (!bulkSpawning)
+	{
+		actor->PostEditChange();
+	}
+	actor->MarkPackageDirty();
 }
 
 AActor* FEntityEmitter::ImportPortableEntityToWorld(const FHL2EntityData& entityData)
@@ -154,11 +482,259 @@ AActor* FEntityEmitter::ImportPortableEntityToWorld(const FHL2EntityData& entity
 		actor->SetActorLabel(FString::Printf(TEXT("%s%i"), *entityData.Classname.ToString(), importCount));
 	}
 	++importCount;
-	actor->PostEditChange();
-	actor->MarkPackageDirty();
+	FinishActor(actor);
 	return actor;
 }
 
+void FEntityEmitter::GenerateStaticProps(FScopedSlowTask* progress)
+{
+	const FHL2EditorBSPConfig& bspConfig = IHL2Editor::Get().GetConfig().BSP;
+
+	const FFolder entitiesFolder(bspConfig.Portable ? fnEntities : fnHL2Entities);
+	FActorFolders& folders = FActorFolders::Get();
+	folders.CreateFolder(*world, entitiesFolder);
+
+	// Convert the model dictionary once, each model is resolved through the cache when first used
+	UClass* entityClass = bspConfig.Portable ? nullptr : ResolveEntityClass(fnPropStatic);
+	if (!bspConfig.Portable && entityClass == nullptr) { return; }
+	TArray<FString> modelNames;
+	modelNames.Reserve((int)bspFile.m_StaticpropStringTable.size());
+	for (const Valve::BSP::StaticPropName_t& staticPropName : bspFile.m_StaticpropStringTable)
+	{
+		const auto& modelRaw = StringCast<TCHAR, 128>(staticPropName.m_Str);
+		modelNames.Add(FString(modelRaw.Length(), modelRaw.Get()));
+	}
+
+	int& importCount = importCountMap.FindOrAdd(fnPropStatic, 0);
+	for (const Valve::BSP::StaticProp_t& staticProp : bspFile.m_Staticprops)
+	{
+		if (progress != nullptr) { progress->EnterProgressFrame(); }
+		const int modelIndex = staticProp.m_PropType;
+		if (!modelNames.IsValidIndex(modelIndex)) { continue; }
+
+		const FVector3f origin(staticProp.m_Origin(0, 0), staticProp.m_Origin(0, 1), staticProp.m_Origin(0, 2));
+		const FVector3f angles(staticProp.m_Angles(0, 0), staticProp.m_Angles(0, 1), staticProp.m_Angles(0, 2));
+		const FVector pos = FVector(SourceToUnreal.Position(origin));
+		const FRotator rot = UHL2EntityDataUtils::ConvertSourceAnglesToUnreal(FVector(angles));
+		if (bspConfig.Portable)
+		{
+			AStaticMeshActor* staticMeshActor = world->SpawnActor<AStaticMeshActor>(pos, rot);
+			if (staticMeshActor == nullptr) { continue; }
+			UStaticMesh* staticMesh = ResolveStaticProp(modelNames[modelIndex]);
+			if (staticMesh != nullptr)
+			{
+				UStaticMeshComponent* staticMeshComponent = staticMeshActor->GetStaticMeshComponent();
+				staticMeshComponent->SetStaticMesh(staticMesh);
+				staticMeshComponent->PostEditChange();
+			}
+			staticMeshActor->SetActorLabel(FString::Printf(TEXT("%s%i"), *fnPropStatic.ToString(), importCount++));
+			staticMeshActor->SetFolderPath(entitiesFolder.GetPath());
+			if (staticProp.m_UniformScale != 1.0f)
+			{
+				staticMeshActor->SetActorScale3D(FVector(staticProp.m_UniformScale));
+			}
+			ApplyStaticPropCullDistance(staticMeshActor, staticProp);
+			FinishActor(staticMeshActor);
+		}
+		else
+		{
+			FPendingEntity pendingEntity;
+			pendingEntity.Transform = FTransform(rot, pos, FVector(staticProp.m_UniformScale));
+			pendingEntity.StaticProp = &staticProp;
+			ABaseEntity* entity = world->SpawnActorDeferred<ABaseEntity>(entityClass, pendingEntity.Transform);
+			if (entity == nullptr) { continue; }
+			pendingEntity.Entity = entity;
+
+			// The blueprint's construction script still reads these keys, so they must be present
+			FHL2EntityData& entityData = entity->EntityData;
+			entityData.Classname = fnPropStatic;
+			entityData.Origin = origin;
+			entityData.KeyValues.Reserve(4);
+			entityData.KeyValues.Add(fnSolidity, FString::FromInt((int)staticProp.m_Solid));
+			entityData.KeyValues.Add(fnModel, modelNames[modelIndex]);
+			entityData.KeyValues.Add(fnAngles, FString::Printf(TEXT("%f %f %f"), angles.X, angles.Y, angles.Z));
+			entityData.KeyValues.Add(fnSkin, FString::FromInt(staticProp.m_Skin));
+			entity->VBSPInfo = vbspInfo;
+			entity->SetFolderPath(entitiesFolder.GetPath());
+			QueueEntity(pendingEntity);
+		}
+	}
+}
+
+void FEntityEmitter::ApplyDefaultBodygroupVariant(AActor* actor) const
+{
+	TInlineComponentArray<UStaticMeshComponent*> staticMeshComponents(actor);
+	for (UStaticMeshComponent* staticMeshComponent : staticMeshComponents)
+	{
+		UStaticMesh* staticMesh = staticMeshComponent->GetStaticMesh();
+		if (staticMesh == nullptr) { continue; }
+		const UHL2ModelData* modelData = staticMesh->GetAssetUserData<UHL2ModelData>();
+		if (modelData == nullptr) { continue; }
+		UStaticMesh* variant = modelData->GetDefaultBakedVariant(staticMesh);
+		if (variant != staticMesh) { staticMeshComponent->SetStaticMesh(variant); }
+	}
+}
+
+void FEntityEmitter::ApplyStaticPropCullDistance(AActor* actor, const Valve::BSP::StaticProp_t& staticProp) const
+{
+	const FHL2EditorBSPConfig& bspConfig = IHL2Editor::Get().GetConfig().BSP;
+
+	// Pixel sizes are converted to distances against a 90 degree vertical fov on a 1080p screen
+	constexpr float referenceScreenHeight = 1080.0f;
+
+	TInlineComponentArray<UStaticMeshComponent*> staticMeshComponents(actor);
+	for (UStaticMeshComponent* staticMeshComponent : staticMeshComponents)
+	{
+		const UStaticMesh* staticMesh = staticMeshComponent->GetStaticMesh();
+		const float radius = staticMesh != nullptr ? staticMesh->GetBounds().SphereRadius * staticProp.m_UniformScale : 0.0f;
+		float cullDistance = 0.0f;
+		if (bspConfig.UseStaticPropFadeDistances && (staticProp.m_Flags & Valve::BSP::STATIC_PROP_FLAG_FADES) && staticProp.m_FadeMaxDist > 0.0f)
+		{
+			// Source fades out between the min and max distances, unreal culls outright, so cull at the end of the fade
+			if (staticProp.m_Flags & Valve::BSP::STATIC_PROP_SCREEN_SPACE_FADE)
+			{
+				cullDistance = radius > 0.0f ? radius * referenceScreenHeight / staticProp.m_FadeMaxDist : 0.0f;
+			}
+			else
+			{
+				cullDistance = staticProp.m_FadeMaxDist * SOURCE_UNIT_SCALE;
+			}
+		}
+		else if (bspConfig.StaticPropCullScreenSize > 0.0f && radius > 0.0f)
+		{
+			cullDistance = radius * referenceScreenHeight / bspConfig.StaticPropCullScreenSize;
+		}
+		if (cullDistance <= 0.0f) { continue; }
+		staticMeshComponent->LDMaxDrawDistance = cullDistance;
+		staticMeshComponent->CachedMaxDrawDistance = cullDistance;
+		staticMeshComponent->MarkRenderStateDirty();
+	}
+}
+
+void FEntityEmitter::GenerateWorldLights()
+{
+	const FFolder lightsFolder(fnLights);
+	FActorFolders& folders = FActorFolders::Get();
+	folders.CreateFolder(*world, lightsFolder);
+
+	int importCount = 0;
+	for (int i = 0; i < (int)worldLights.size(); ++i)
+	{
+		if (claimedWorldLights[i]) { continue; }
+		const Valve::BSP::dworldlight_t& worldLight = worldLights[i];
+		if (worldLight.m_Type != Valve::BSP::emit_point && worldLight.m_Type != Valve::BSP::emit_spotlight) { continue; }
+
+		// Lights parented to a brush entity move with it, which is not supported yet
+		if (worldLight.m_Owner != 0) { continue; }
+
+		AActor* actor = SpawnWorldLight(worldLight);
+		if (actor == nullptr) { continue; }
+		actor->SetActorLabel(FString::Printf(TEXT("worldlight%i"), importCount++));
+		actor->SetFolderPath(lightsFolder.GetPath());
+		FinishActor(actor);
+	}
+}
+
+float FEntityEmitter::ComputeWorldLightRadius(const Valve::BSP::dworldlight_t& worldLight, bool isHDR)
+{
+	// Mirrors how the engine bounds a light with no explicit cutoff distance:
+	// solve intensity / (constant + linear * d + quadratic * d^2) = minLightValue for d
+	if (worldLight.m_Radius > 0.0f) { return worldLight.m_Radius; }
+
+	const float minLightValue = isHDR ? WorldLightCutoffHDR : WorldLightCutoffLDR;
+	const FVector3f intensity(worldLight.m_Intensity(0, 0), worldLight.m_Intensity(0, 1), worldLight.m_Intensity(0, 2));
+	const float magnitude = intensity.Size();
+	if (worldLight.m_QuadraticAttn == 0.0f)
+	{
+		if (worldLight.m_LinearAttn == 0.0f) { return WorldLightInfiniteRadius; }
+		return FMath::Max(0.0f, (magnitude / minLightValue - worldLight.m_ConstantAttn) / worldLight.m_LinearAttn);
+	}
+	const float a = worldLight.m_QuadraticAttn;
+	const float b = worldLight.m_LinearAttn;
+	const float c = worldLight.m_ConstantAttn - magnitude / minLightValue;
+	const float discrim = b * b - 4.0f * a * c;
+	if (discrim < 0.0f) { return WorldLightInfiniteRadius; }
+	return FMath::Max(0.0f, (-b + FMath::Sqrt(discrim)) / (2.0f * a));
+}
+
+const Valve::BSP::dworldlight_t* FEntityEmitter::ClaimWorldLight(const FHL2EntityData& entityData)
+{
+	// Several lights may share an origin, stacked or switchable, so claim the first one that is still unclaimed
+	int worldLightIndex = INDEX_NONE;
+	for (TMultiMap<FIntVector, int>::TConstKeyIterator it = worldLightsByOrigin.CreateConstKeyIterator(GetWorldLightKey(entityData.Origin)); it; ++it)
+	{
+		if (claimedWorldLights[it.Value()]) { continue; }
+		if (worldLightIndex == INDEX_NONE || it.Value() < worldLightIndex) { worldLightIndex = it.Value(); }
+	}
+	if (worldLightIndex == INDEX_NONE) { return nullptr; }
+	claimedWorldLights[worldLightIndex] = true;
+	return &worldLights[worldLightIndex];
+}
+
+AActor* FEntityEmitter::SpawnWorldLight(const Valve::BSP::dworldlight_t& worldLight)
+{
+	const FVector3f pos = SourceToUnreal.Position(FVector3f(worldLight.m_Origin(0, 0), worldLight.m_Origin(0, 1), worldLight.m_Origin(0, 2)));
+	ULocalLightComponent* lightComponent;
+	AActor* actor;
+	if (worldLight.m_Type == Valve::BSP::emit_spotlight)
+	{
+		const FVector3f dir = SourceToUnreal.Direction(FVector3f(worldLight.m_Normal(0, 0), worldLight.m_Normal(0, 1), worldLight.m_Normal(0, 2)));
+		ASpotLight* spotLight = world->SpawnActor<ASpotLight>(FVector(pos), FVector(dir).Rotation());
+		if (spotLight == nullptr) { return nullptr; }
+		lightComponent = spotLight->SpotLightComponent;
+		actor = spotLight;
+	}
+	else
+	{
+		APointLight* pointLight = world->SpawnActor<APointLight>(FVector(pos), FRotator::ZeroRotator);
+		if (pointLight == nullptr) { return nullptr; }
+		lightComponent = pointLight->PointLightComponent;
+		actor = pointLight;
+	}
+	ApplyWorldLight(lightComponent, worldLight);
+
+	// Lights with a style flicker or are switched, so only plain lights are fully baked
+	// Set last, as a registered static light ignores changes to its properties
+	lightComponent->SetMobility(worldLight.m_Style == 0 ? EComponentMobility::Static : EComponentMobility::Stationary);
+	return actor;
+}
+
+void FEntityEmitter::ApplyWorldLight(ULocalLightComponent* lightComponent, const Valve::BSP::dworldlight_t& worldLight) const
+{
+	const FHL2EditorBSPConfig& bspConfig = IHL2Editor::Get().GetConfig().BSP;
+
+	// Colour is the normalised intensity, brightness is its peak channel
+	const FVector3f intensity(worldLight.m_Intensity(0, 0), worldLight.m_Intensity(0, 1), worldLight.m_Intensity(0, 2));
+	const float peak = intensity.GetMax();
+	if (peak > 0.0f)
+	{
+		lightComponent->SetLightColor(FLinearColor(intensity.X / peak, intensity.Y / peak, intensity.Z / peak));
+		lightComponent->SetIntensity(peak * bspConfig.WorldLightIntensityScale);
+	}
+
+	lightComponent->SetAttenuationRadius(ComputeWorldLightRadius(worldLight, worldLightsAreHDR) * SOURCE_UNIT_SCALE);
+
+	UPointLightComponent* pointLightComponent = Cast<UPointLightComponent>(lightComponent);
+	if (pointLightComponent != nullptr)
+	{
+		// Only quadratic falloff maps onto a physically based light, anything else falls back to exponent falloff
+		pointLightComponent->bUseInverseSquaredFalloff = worldLight.m_QuadraticAttn > 0.0f;
+		if (!pointLightComponent->bUseInverseSquaredFalloff)
+		{
+			pointLightComponent->SetLightFalloffExponent(worldLight.m_LinearAttn > 0.0f ? 1.0f : 0.0f);
+		}
+	}
+
+	USpotLightComponent* spotLightComponent = Cast<USpotLightComponent>(lightComponent);
+	if (spotLightComponent != nullptr && worldLight.m_Type == Valve::BSP::emit_spotlight)
+	{
+		spotLightComponent->SetInnerConeAngle(FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(worldLight.m_Stopdot, -1.0f, 1.0f))));
+		spotLightComponent->SetOuterConeAngle(FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(worldLight.m_Stopdot2, -1.0f, 1.0f))));
+	}
+
+	lightComponent->PostEditChange();
+}
+
 #pragma region Portable Entity Importers
 
 AActor* FEntityEmitter::ImportPortableProp(const FHL2EntityData& entityData)
@@ -168,7 +744,18 @@ AActor* FEntityEmitter::ImportPortableProp(const FHL2EntityData& entityData)
 	const FString model = entityData.GetString(fnModel);
 	if (entityData.Classname == fnPropPhysics || entityData.Classname == fnPropDynamic)
 	{
-		USkeletalMesh* skeletalMesh = IHL2Runtime::Get().TryResolveHL2AnimatedProp(model);
+		// A skeletal prop that can never animate costs much less as a static mesh
+		UStaticMesh* rigidStaticMesh = IsNeverAnimated(entityData) ? ResolveRigidProp(model) : nullptr;
+		USkeletalMesh* skeletalMesh = rigidStaticMesh == nullptr ? ResolveAnimatedProp(model) : nullptr;
+		if (rigidStaticMesh != nullptr)
+		{
+			AStaticMeshActor* actor = world->SpawnActor<AStaticMeshActor>(FVector(pos), rot);
+			if (actor == nullptr) { return nullptr; }
+			UStaticMeshComponent* staticMeshComponent = CastChecked<UStaticMeshComponent>(actor->GetRootComponent());
+			staticMeshComponent->SetStaticMesh(rigidStaticMesh);
+			staticMeshComponent->PostEditChange();
+			return Cast<AActor>(actor);
+		}
 		if (skeletalMesh != nullptr)
 		{
 			ASkeletalMeshActor* actor = world->SpawnActor<ASkeletalMeshActor>(FVector(pos), rot);
@@ -181,7 +768,7 @@ AActor* FEntityEmitter::ImportPortableProp(const FHL2EntityData& entityData)
 	}
 	AStaticMeshActor* actor = world->SpawnActor<AStaticMeshActor>(FVector(pos), rot);
 	if (actor == nullptr) { return nullptr; }
-	UStaticMesh* staticMesh = IHL2Runtime::Get().TryResolveHL2StaticProp(model);
+	UStaticMesh* staticMesh = ResolveStaticProp(model);
 	UStaticMeshComponent* staticMeshComponent = CastChecked<UStaticMeshComponent>(actor->GetRootComponent());
 	if (staticMesh != nullptr)
 	{
@@ -198,11 +785,9 @@ AActor* FEntityEmitter::ImportPortableBrush(const FHL2EntityData& entityData)
 	AStaticMeshActor* actor = world->SpawnActor<AStaticMeshActor>(FVector(pos), FRotator::ZeroRotator);
 	if (actor == nullptr) { return nullptr; }
 	UStaticMeshComponent* staticMeshComponent = CastChecked<UStaticMeshComponent>(actor->GetRootComponent());
-	static const FRegexPattern patternWorldModel(TEXT("^\\*([0-9]+)$"));
-	FRegexMatcher matchWorldModel(patternWorldModel, model);
-	if (matchWorldModel.FindNext())
+	int modelIndex;
+	if (TryParseBrushModelIndex(model, modelIndex))
 	{
-		int modelIndex = FCString::Atoi(*matchWorldModel.GetCaptureGroup(1));
 		check(bspModels.IsValidIndex(modelIndex));
 		staticMeshComponent->SetStaticMesh(bspModels[modelIndex]);
 		staticMeshComponent->PostEditChange();
@@ -233,7 +818,13 @@ AActor* FEntityEmitter::ImportPortableLight(const FHL2EntityData& entityData)
 		return Cast<AActor>(actor);
 	}
 
-	// TODO: light and light_spot
+	if (entityData.Classname == fnLight || entityData.Classname == fnLightSpot)
+	{
+		// Only the compiled worldlight carries the final falloff, so use that rather than the entity keys
+		const Valve::BSP::dworldlight_t* worldLight = ClaimWorldLight(entityData);
+		if (worldLight == nullptr) { return nullptr; }
+		return SpawnWorldLight(*worldLight);
+	}
 	
 	return nullptr;
 }
@@ -8,8 +8,22 @@
 
 using PortableEntityImporterFunc = TFunction<AActor*(const FHL2EntityData&)>;
 
+class ULocalLightComponent;
+class FScopedTransaction;
+
 class FEntityEmitter
 {
+private:
+
+	/** An entity spawned with deferred construction, waiting to be finalised. */
+	struct FPendingEntity
+	{
+		ABaseEntity* Entity = nullptr;
+		FTransform Transform;
+		const Valve::BSP::dworldlight_t* WorldLight = nullptr;
+		const Valve::BSP::StaticProp_t* StaticProp = nullptr;
+	};
+
 private:
 
 	UWorld* world;
@@ -20,20 +34,104 @@ private:
 	TMap<FName, PortableEntityImporterFunc> portableEntityImporters;
 	TMap<FName, int> importCountMap;
 
+	TMap<FName, UClass*> entityClassCache;
+	TMap<FString, UStaticMesh*> staticPropCache;
+	TMap<FString, USkeletalMesh*> animatedPropCache;
+	TMap<FString, UStaticMesh*> rigidPropCache;
+
+	// Targets of any logic output that drives animation, gathered before portable props are imported
+	TSet<FName> animatedTargetNames;
+	TArray<FString> animatedTargetPrefixes;
+
+	const std::vector<Valve::BSP::dworldlight_t>& worldLights;
+	bool worldLightsAreHDR;
+	TMultiMap<FIntVector, int> worldLightsByOrigin;
+	TBitArray<> claimedWorldLights;
+
+	bool bulkSpawning;
+	bool previousTemporaryCachingMode;
+	TUniquePtr<FScopedTransaction> bulkTransaction;
+	TArray<FPendingEntity> pendingEntities;
+
+	// Actors imported during the batch, selected together when it ends
+	TArray<AActor*> importedActors;
+
+	TArray<ABaseEntity*> spawnedEntities;
+
 public:
 
 	FEntityEmitter(UWorld* world, const Valve::BSPFile& bspFile, const TArray<UStaticMesh*>& bspModels, AVBSPInfo* vbspInfo);
 
+	~FEntityEmitter();
+
 public:
 
+	/**
+	 * Begins a bulk spawn. Until EndBulkSpawn, entities are spawned with deferred construction, all spawns share one transaction,
+	 * and selection notifications and asset registry class hierarchy refreshes are held back.
+	 */
+	void BeginBulkSpawn();
+
+	/** Finishes spawning every deferred entity in one pass, then ends the transaction and issues a single selection update. */
+	void EndBulkSpawn(FScopedSlowTask* progress = nullptr);
+
 	void GenerateActors(const TArrayView<FHL2EntityData>& entityDatas, FScopedSlowTask* progress = nullptr);
 
+	/** Spawns all static props straight from the parsed sprp game lump, resolving each model in the dictionary at most once. */
+	void GenerateStaticProps(FScopedSlowTask* progress = nullptr);
+
+	/**
+	 * Resolves the non-wildcard, non-special targets of every spawned entity's logic outputs to soft references,
+	 * so they do not need to be looked up by name when fired. Called by EndBulkSpawn.
+	 */
+	void ResolveLogicOutputTargets();
+
+	/** Emits unreal lights for all point and spot worldlights that were not claimed by a light entity during GenerateActors. */
+	void GenerateWorldLights();
+
+	/** Parses a brush model reference of the form "*N" into its model index. */
+	static bool TryParseBrushModelIndex(const FString& model, int& outModelIndex);
+
+	/** Gets the distance at which the worldlight falls below the engine's visible threshold, in source units. */
+	static float ComputeWorldLightRadius(const Valve::BSP::dworldlight_t& worldLight, bool isHDR);
+
 private:
 
+	UClass* ResolveEntityClass(const FName classname);
+
+	UStaticMesh* ResolveStaticProp(const FString& model);
+
+	USkeletalMesh* ResolveAnimatedProp(const FString& model);
+
+	UStaticMesh* ResolveRigidProp(const FString& model);
+
+	/** Gathers the names of all entities that some logic output may play an animation on. */
+	void GatherAnimatedTargets(const TArrayView<FHL2EntityData>& entityDatas);
+
+	/** Gets whether nothing in the map can make the prop play an animation, neither its keyvalues nor any input sent to it. */
+	bool IsNeverAnimated(const FHL2EntityData& entityData) const;
+
 	ABaseEntity* ImportEntityToWorld(const FHL2EntityData& entityData);
 
+	void QueueEntity(const FPendingEntity& pendingEntity);
+
+	void FinishEntity(const FPendingEntity& pendingEntity);
+
+	void FinishActor(AActor* actor) const;
+
 	AActor* ImportPortableEntityToWorld(const FHL2EntityData& entityData);
 
+	const Valve::BSP::dworldlight_t* ClaimWorldLight(const FHL2EntityData& entityData);
+
+	/** Swaps any static mesh on the actor that has baked bodygroup variants to its default variant. */
+	void ApplyDefaultBodygroupVariant(AActor* actor) const;
+
+	void ApplyStaticPropCullDistance(AActor* actor, const Valve::BSP::StaticProp_t& staticProp) const;
+
+	AActor* SpawnWorldLight(const Valve::BSP::dworldlight_t& worldLight);
+
+	void ApplyWorldLight(ULocalLightComponent* lightComponent, const Valve::BSP::dworldlight_t& worldLight) const;
+
 #pragma region Portable Entity Importers
 
 	AActor* ImportPortableProp(const FHL2EntityData& entityData);
@@ -2,74 +2,135 @@
 
 #include "EntityParser.h"
 
-#include "Internationalization/Regex.h"
-
-bool FEntityParser::ParseEntities(const FString& src, TArray<FHL2EntityData>& out)
+bool FEntityParser::ParseEntities(const ANSICHAR* src, int32 length, TArray<FHL2EntityData>& out)
 {
-	const UValveDocument* document = UValveDocument::Parse(src);
-	if (document == nullptr) { return false; }
+	const ANSICHAR* cur = src;
+	const ANSICHAR* end = src + length;
 
-	const UValveArrayValue* arrayValue = CastChecked<UValveArrayValue>(document->Root);
+	// Every entity opens with a brace, so this is a cheap upper bound for the number of entities
+	int entityCount = 0;
+	for (const ANSICHAR* ch = cur; ch < end; ++ch)
+	{
+		if (*ch == '{') { ++entityCount; }
+	}
+	out.Reserve(out.Num() + entityCount);
 
-	TMap<FName, FString> keyValues;
-	TArray<FEntityLogicOutput> logicOutputs;
-	for (const UValveValue* value : arrayValue->Items)
+	while (true)
 	{
-		const UValveGroupValue* groupValue = CastChecked<UValveGroupValue>(value);
-		if (ParseGroup(groupValue, keyValues, logicOutputs))
+		SkipWhitespace(cur, end);
+		if (cur >= end) { break; }
+		if (*cur != '{') { return false; }
+		++cur;
+
+		FHL2EntityData& entity = out.AddDefaulted_GetRef();
+		while (true)
 		{
-			FHL2EntityData entity;
-			entity.KeyValues = keyValues;
-			entity.LogicOutputs = logicOutputs;
-			ParseCommonKeys(entity);
-			out.Add(entity);
-			keyValues.Empty();
-			logicOutputs.Empty();
+			SkipWhitespace(cur, end);
+			if (cur >= end) { return false; }
+			if (*cur == '}')
+			{
+				++cur;
+				break;
+			}
+			FAnsiStringView key, value;
+			if (!ReadString(cur, end, key) || !ReadString(cur, end, value)) { return false; }
+			const FName keyName(key.Len(), key.GetData());
+			if (!TryParseLogicOutput(keyName, value, entity.LogicOutputs))
+			{
+				entity.KeyValues.Add(keyName, FString(value.Len(), value.GetData()));
+			}
+		}
+		ParseCommonKeys(entity);
+	}
+	return true;
+}
+
+void FEntityParser::SkipWhitespace(const ANSICHAR*& cur, const ANSICHAR* end)
+{
+	while (cur < end)
+	{
+		// The lump is null terminated, treat that and any control characters as whitespace
+		if ((uint8)*cur <= ' ')
+		{
+			++cur;
+		}
+		else if (*cur == '/' && cur + 1 < end && cur[1] == '/')
+		{
+			while (cur < end && *cur != '\n') { ++cur; }
 		}
 		else
 		{
-			return false;
+			break;
 		}
 	}
+}
+
+bool FEntityParser::ReadString(const ANSICHAR*& cur, const ANSICHAR* end, FAnsiStringView& out)
+{
+	SkipWhitespace(cur, end);
+	if (cur >= end) { return false; }
+
+	// Entity lumps have no escape sequences, a quoted string simply runs to the next quote
+	if (*cur == '"')
+	{
+		const ANSICHAR* start = ++cur;
+		while (cur < end && *cur != '"') { ++cur; }
+		if (cur >= end) { return false; }
+		out = FAnsiStringView(start, (int32)(cur - start));
+		++cur;
+		return true;
+	}
+
+	const ANSICHAR* start = cur;
+	while (cur < end && (uint8)*cur > ' ' && *cur != '"' && *cur != '{' && *cur != '}') { ++cur; }
+	if (cur == start) { return false; }
+	out = FAnsiStringView(start, (int32)(cur - start));
 	return true;
 }
 
-bool FEntityParser::ParseGroup(const UValveGroupValue* group, TMap<FName, FString>& outKeyValues, TArray<FEntityLogicOutput>& outLogicOutputs)
+/** Copies a field into a null terminated buffer, truncating it if needed, so that it can be converted without reading past the field. */
+template<int32 N>
+static const ANSICHAR* TerminateField(const FAnsiStringView field, ANSICHAR (&buffer)[N])
+{
+	const int32 len = FMath::Min(field.Len(), N - 1);
+	FMemory::Memcpy(buffer, field.GetData(), len);
+	buffer[len] = '\0';
+	return buffer;
+}
+
+bool FEntityParser::TryParseLogicOutput(const FName outputName, const FAnsiStringView value, TArray<FEntityLogicOutput>& outLogicOutputs)
 {
-	for (const FValveGroupKeyValue& kv : group->Items)
+	// Outputs are "target,input,params...,delay,times", newer compilers separate them with ESC instead so that params may contain commas
+	int32 escIndex;
+	const ANSICHAR separator = value.FindChar('\x1B', escIndex) ? '\x1B' : ',';
+	TArray<FAnsiStringView, TInlineAllocator<8>> logicArgs;
+	int32 argStart = 0;
+	for (int32 i = 0; i <= value.Len(); ++i)
 	{
-		const UValvePrimitiveValue* primitiveValue = Cast<UValvePrimitiveValue>(kv.Value);
-		if (primitiveValue != nullptr)
+		if (i == value.Len() || value[i] == separator)
 		{
-			const FString value = primitiveValue->AsString();
-
-			// Check logic output
-			TArray<FString> logicArgs;
-			value.ParseIntoArray(logicArgs, TEXT(","), false);
-			if (logicArgs.Num() >= 4)
-			{
-				FEntityLogicOutput logicOutput;
-				logicArgs[0].TrimEndInline();
-				logicArgs[0].TrimStartInline();
-				logicOutput.TargetName = FName(*logicArgs[0]);
-				logicOutput.OutputName = kv.Key;
-				logicArgs[1].TrimEndInline();
-				logicArgs[1].TrimStartInline();
-				logicOutput.InputName = FName(*logicArgs[1]);
-				logicOutput.Delay = FCString::Atof(*logicArgs.Last(1));
-				logicOutput.Once = FCString::Atoi(*logicArgs.Last(0)) != -1;
-				logicArgs.RemoveAt(logicArgs.Num() - 2, 2);
-				logicArgs.RemoveAt(0, 2);
-				logicOutput.Params = logicArgs;
-				outLogicOutputs.Add(logicOutput);
-			}
-			else
-			{
-				outKeyValues.Add(kv.Key, value);
-			}
+			logicArgs.Add(value.Mid(argStart, i - argStart));
+			argStart = i + 1;
 		}
 	}
+	if (logicArgs.Num() < 4) { return false; }
 
+	FEntityLogicOutput& logicOutput = outLogicOutputs.AddDefaulted_GetRef();
+	const FAnsiStringView targetName = logicArgs[0].TrimStartAndEnd();
+	logicOutput.TargetName = FName(targetName.Len(), targetName.GetData());
+	logicOutput.OutputName = outputName;
+	const FAnsiStringView inputName = logicArgs[1].TrimStartAndEnd();
+	logicOutput.InputName = FName(inputName.Len(), inputName.GetData());
+
+	// The last field may end the lump without a closing quote, so numbers are never read in place
+	ANSICHAR numberBuffer[32];
+	logicOutput.Delay = FCStringAnsi::Atof(TerminateField(logicArgs.Last(1), numberBuffer));
+	logicOutput.Once = FCStringAnsi::Atoi(TerminateField(logicArgs.Last(0), numberBuffer)) != -1;
+	logicOutput.Params.Reserve(logicArgs.Num() - 4);
+	for (int i = 2; i < logicArgs.Num() - 2; ++i)
+	{
+		logicOutput.Params.Emplace(logicArgs[i].Len(), logicArgs[i].GetData());
+	}
 	return true;
 }
 
@@ -84,4 +145,5 @@ inline void FEntityParser::ParseCommonKeys(FHL2EntityData& entity)
 	entity.TryGetString(kTargetname, entity.Targetname);
 	entity.TryGetVector(kOrigin, entity.Origin);
 	entity.TryGetInt(kSpawnflags, entity.SpawnFlags);
-}
\ No newline at end of file
+	entity.CacheCommonTypedValues();
+}
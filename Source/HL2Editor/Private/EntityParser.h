@@ -2,7 +2,6 @@
 
 #include "CoreMinimal.h"
 #include "HL2EntityData.h"
-#include "ValveKeyValues.h"
 
 class FEntityParser
 {
@@ -13,13 +12,18 @@ private:
 public:
 
 	/**
-	 * Parses a string from a vbsp entity lump into an array of entities.
+	 * Parses the raw bytes of a vbsp entity lump into an array of entities.
+	 * Works in a single pass over the text, recognising logic outputs as it goes.
 	 */
-	static bool ParseEntities(const FString& src, TArray<FHL2EntityData>& out);
+	static bool ParseEntities(const ANSICHAR* src, int32 length, TArray<FHL2EntityData>& out);
 
 private:
 
-	static bool ParseGroup(const UValveGroupValue* group, TMap<FName, FString>& outKeyValues, TArray<FEntityLogicOutput>& outLogicOutputs);
+	static void SkipWhitespace(const ANSICHAR*& cur, const ANSICHAR* end);
+
+	static bool ReadString(const ANSICHAR*& cur, const ANSICHAR* end, FAnsiStringView& out);
+
+	static bool TryParseLogicOutput(const FName outputName, const FAnsiStringView value, TArray<FEntityLogicOutput>& outLogicOutputs);
 
 	inline static void ParseCommonKeys(FHL2EntityData& entity);
 };
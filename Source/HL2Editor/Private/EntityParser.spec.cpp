@@ -0,0 +1,97 @@
+#include "Misc/AutomationTest.h"
+#include "EntityParser.h"
+
+BEGIN_DEFINE_SPEC(EntityParserSpec, "HL2.EntityParser.Spec", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+TArray<FHL2EntityData> Entities;
+bool Parse(const ANSICHAR* src);
+const FEntityLogicOutput* ParseSingleOutput(const ANSICHAR* src);
+END_DEFINE_SPEC(EntityParserSpec)
+
+bool EntityParserSpec::Parse(const ANSICHAR* src)
+{
+	Entities.Reset();
+	return FEntityParser::ParseEntities(src, FCStringAnsi::Strlen(src), Entities);
+}
+
+const FEntityLogicOutput* EntityParserSpec::ParseSingleOutput(const ANSICHAR* src)
+{
+	if (!TestTrue("ParseEntities", Parse(src))) { return nullptr; }
+	if (!TestEqual("Entities.Num()", Entities.Num(), 1)) { return nullptr; }
+	if (!TestEqual("LogicOutputs.Num()", Entities[0].LogicOutputs.Num(), 1)) { return nullptr; }
+	return &Entities[0].LogicOutputs[0];
+}
+
+void EntityParserSpec::Define()
+{
+	Describe("FEntityParser", [this]()
+		{
+			Describe("ParseEntities", [this]()
+				{
+					It("will parse keyvalues and common keys", [this]()
+						{
+							if (!TestTrue("ParseEntities", Parse("{\n\"classname\" \"info_target\"\n\"targetname\" \"foo\"\n\"origin\" \"1 2 3\"\n}\n"))) { return; }
+							if (!TestEqual("Entities.Num()", Entities.Num(), 1)) { return; }
+							TestEqual("Classname", Entities[0].Classname, FName(TEXT("info_target")));
+							TestEqual("Targetname", Entities[0].Targetname, TEXT("foo"));
+							TestEqual("Origin", Entities[0].Origin, FVector3f(1.0f, 2.0f, 3.0f));
+						});
+
+					It("will parse comma separated logic outputs", [this]()
+						{
+							const FEntityLogicOutput* output = ParseSingleOutput("{\n\"classname\" \"logic_relay\"\n\"OnTrigger\" \"door,Open,,1.5,-1\"\n}\n");
+							if (output == nullptr) { return; }
+							TestEqual("OutputName", output->OutputName, FName(TEXT("OnTrigger")));
+							TestEqual("TargetName", output->TargetName, FName(TEXT("door")));
+							TestEqual("InputName", output->InputName, FName(TEXT("Open")));
+							TestEqual("Params.Num()", output->Params.Num(), 1);
+							TestEqual("Delay", output->Delay, 1.5f);
+							TestFalse("Once", output->Once);
+						});
+
+					It("will parse ESC separated logic outputs", [this]()
+						{
+							const FEntityLogicOutput* output = ParseSingleOutput("{\n\"classname\" \"logic_relay\"\n\"OnTrigger\" \"door\x1BSetSpeed\x1B" "100\x1B" "0\x1B" "1\"\n}\n");
+							if (output == nullptr) { return; }
+							TestEqual("TargetName", output->TargetName, FName(TEXT("door")));
+							TestEqual("InputName", output->InputName, FName(TEXT("SetSpeed")));
+							if (!TestEqual("Params.Num()", output->Params.Num(), 1)) { return; }
+							TestEqual("Params[0]", output->Params[0], TEXT("100"));
+							TestEqual("Delay", output->Delay, 0.0f);
+							TestTrue("Once", output->Once);
+						});
+
+					It("will keep commas within the params of ESC separated logic outputs", [this]()
+						{
+							const FEntityLogicOutput* output = ParseSingleOutput("{\n\"classname\" \"logic_relay\"\n\"OnTrigger\" \"!self\x1B" "AddOutput\x1BOnUser1 door,Close,,0,-1\x1B" "2\x1B-1\"\n}\n");
+							if (output == nullptr) { return; }
+							TestEqual("TargetName", output->TargetName, FName(TEXT("!self")));
+							TestEqual("InputName", output->InputName, FName(TEXT("AddOutput")));
+							if (!TestEqual("Params.Num()", output->Params.Num(), 1)) { return; }
+							TestEqual("Params[0]", output->Params[0], TEXT("OnUser1 door,Close,,0,-1"));
+							TestEqual("Delay", output->Delay, 2.0f);
+							TestFalse("Once", output->Once);
+						});
+
+					It("will not read the numbers of a logic output past the end of the lump", [this]()
+						{
+							// The lump ends partway through the last field, the bytes after it must not be read
+							const ANSICHAR* src = "{\nOnTrigger door,Open,,1,-15\n}\n";
+							const int32 length = FCStringAnsi::Strlen(src) - 4;
+							Entities.Reset();
+							TestFalse("ParseEntities", FEntityParser::ParseEntities(src, length, Entities));
+							if (!TestEqual("Entities.Num()", Entities.Num(), 1)) { return; }
+							if (!TestEqual("LogicOutputs.Num()", Entities[0].LogicOutputs.Num(), 1)) { return; }
+							TestEqual("Delay", Entities[0].LogicOutputs[0].Delay, 1.0f);
+							TestFalse("Once", Entities[0].LogicOutputs[0].Once);
+						});
+
+					It("will keep values with too few fields as keyvalues", [this]()
+						{
+							if (!TestTrue("ParseEntities", Parse("{\n\"classname\" \"info_target\"\n\"angles\" \"0,90,0\"\n}\n"))) { return; }
+							if (!TestEqual("Entities.Num()", Entities.Num(), 1)) { return; }
+							TestEqual("LogicOutputs.Num()", Entities[0].LogicOutputs.Num(), 0);
+							TestEqual("angles", Entities[0].GetString(FName(TEXT("angles"))), TEXT("0,90,0"));
+						});
+				});
+		});
+}
@@ -126,6 +126,12 @@ UObject* UMDLFactory::FactoryCreateFile(
 		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, animSequence);
 		animSequence->PostEditChange();
 	}
+	if (result.RigidStaticMesh != nullptr)
+	{
+		result.RigidStaticMesh->GetAssetImportData()->Update(CurrentFilename, FileHash.IsValid() ? &FileHash : nullptr);
+		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, result.RigidStaticMesh);
+		result.RigidStaticMesh->PostEditChange();
+	}
 	
 	return result.StaticMesh != nullptr ? (UObject*)result.StaticMesh : (UObject*)result.SkeletalMesh;
 }
@@ -359,6 +365,20 @@ FImportedMDL UMDLFactory::ImportStudioModel(UClass* inClass, UObject* inParent,
 	animPackagePath.Append(TEXT("_anims/"));
 	ImportSequences(header, result.SkeletalMesh, animPackagePath, aniHeader, result.Animations, warn);
 
+	// Static mesh for props that can never visibly animate
+	if (IHL2Editor::Get().GetConfig().Model.ImportRigidStaticMeshes && IsNeverAnimated(header, vvdHeader))
+	{
+		FString rigidPackagePath = inParent->GetPathName();
+		rigidPackagePath.Append(TEXT("_static"));
+		UPackage* rigidPackage = CreatePackage(*rigidPackagePath);
+		result.RigidStaticMesh = ImportStaticMesh(rigidPackage, FName(*FPaths::GetBaseFilename(rigidPackagePath)), flags, header, vtxHeader, vvdHeader, phyHeader, warn);
+		if (result.RigidStaticMesh != nullptr)
+		{
+			FAssetRegistryModule::AssetCreated(result.RigidStaticMesh);
+			result.RigidStaticMesh->MarkPackageDirty();
+		}
+	}
+
 	// Includes
 	TArray<const Valve::MDL::mstudiomodelgroup_t*> includes;
 	header.GetIncludeModels(includes);
@@ -632,6 +652,26 @@ UStaticMesh* UMDLFactory::ImportStaticMesh
 					}*/
 				}
 
+				// Convert every vertex to unreal space up front, rather than once per triangle corner
+				TArray<FVector3f> unrealPositions;
+				TArray<FVector3f> unrealNormals;
+				TArray<FVector3f> unrealTangents;
+				{
+					const int vertCount = vvdVertices.Num();
+					unrealPositions.SetNumUninitialized(vertCount);
+					unrealNormals.SetNumUninitialized(vertCount);
+					unrealTangents.SetNumUninitialized(vertCount);
+					for (int i = 0; i < vertCount; ++i)
+					{
+						unrealPositions[i] = vvdVertices[i].m_vecPosition;
+						unrealNormals[i] = vvdVertices[i].m_vecNormal;
+						unrealTangents[i] = FVector3f(vvdTangents[i].X, vvdTangents[i].Y, vvdTangents[i].Z);
+					}
+					StudioMdlToUnreal.Positions(unrealPositions, unrealPositions);
+					StudioMdlToUnreal.Directions(unrealNormals, unrealNormals);
+					StudioMdlToUnreal.Directions(unrealTangents, unrealTangents);
+				}
+
 				// Fetch and iterate all meshes
 				TArray<const Valve::VTX::MeshHeader_t*> vtxMeshes;
 				lod.GetMeshes(vtxMeshes);
@@ -729,14 +769,13 @@ UStaticMesh* UMDLFactory::ImportStaticMesh
 								for (int j = 0; j < 3; ++j)
 								{
 									const Valve::VVD::mstudiovertex_t& vvdVertex = vvdVertices[baseIdxs[j]];
-									const FVector4f& vvdTangent = vvdTangents[baseIdxs[j]];
 
 									FVertexID vertID = localMeshData.meshDescription.CreateVertex();
-									localMeshData.vertPos[vertID] = StudioMdlToUnreal.Position(vvdVertex.m_vecPosition);
+									localMeshData.vertPos[vertID] = unrealPositions[baseIdxs[j]];
 
 									FVertexInstanceID vertInstID = localMeshData.meshDescription.CreateVertexInstance(vertID);
-									localMeshData.vertInstNormal[vertInstID] = StudioMdlToUnreal.Direction(vvdVertex.m_vecNormal);
-									localMeshData.vertInstTangent[vertInstID] = StudioMdlToUnreal.Direction(FVector3f(vvdTangent.X, vvdTangent.Y, vvdTangent.Z));
+									localMeshData.vertInstNormal[vertInstID] = unrealNormals[baseIdxs[j]];
+									localMeshData.vertInstTangent[vertInstID] = unrealTangents[baseIdxs[j]];
 									localMeshData.vertInstUV0[vertInstID] = vvdVertex.m_vecTexCoord;
 
 									tmpVertInstIDs.Add(vertInstID);
@@ -786,6 +825,7 @@ UStaticMesh* UMDLFactory::ImportStaticMesh
 	}
 	
 	constexpr bool debugPhysics = false; // if true, the physics mesh is rendered instead
+	TArray<FMeshDescription> rawLODs;
 
 	// Write all lods to the static mesh
 	if (!debugPhysics || phyHeader == nullptr)
@@ -802,44 +842,20 @@ UStaticMesh* UMDLFactory::ImportStaticMesh
 			staticMaterials.Add(material);
 		}
 		staticMesh->SetStaticMaterials(staticMaterials);
-		for (int lodIndex = 0; lodIndex < vtxHeader.numLODs; ++lodIndex)
-		{
-			// Setup source model
-			FStaticMeshSourceModel& sourceModel = staticMesh->AddSourceModel();
-			FMeshBuildSettings& settings = sourceModel.BuildSettings;
-			settings.bRecomputeNormals = false;
-			settings.bRecomputeTangents = false;
-			settings.bGenerateLightmapUVs = false;
-			settings.SrcLightmapIndex = 0;
-			settings.DstLightmapIndex = 1;
-			settings.bRemoveDegenerates = false;
-			settings.bUseFullPrecisionUVs = true;
-			settings.MinLightmapResolution = 64;
-			sourceModel.ScreenSize.Default = FMath::Pow(0.5f, lodIndex + 1.0f);
-
-			// Fetch and prepare our mesh description
-			FMeshDescription& localMeshDescription = localMeshDatas[lodIndex].meshDescription;
-			FMeshUtils::Clean(localMeshDescription);
 
-			// Generate lightmap coords
-			{
-				localMeshDescription.VertexInstanceAttributes().SetAttributeChannelCount(MeshAttribute::VertexInstance::TextureCoordinate, 2);
-				FOverlappingCorners overlappingCorners;
-				FStaticMeshOperations::FindOverlappingCorners(overlappingCorners, localMeshDescription, 0.00001f);
-				FStaticMeshOperations::CreateLightMapUVLayout(localMeshDescription, settings.SrcLightmapIndex, settings.DstLightmapIndex, settings.MinLightmapResolution, ELightmapUVVersion::Latest, overlappingCorners);
-			}
-
-			// Clean again but this time weld - we do weld after lightmap uv layout because welded vertices sometimes break that algorithm for whatever reason
+		// Keep the unprepared lods around if we're going to bake bodygroup combinations from them
+		if (modelData != nullptr && IHL2Editor::Get().GetConfig().Model.BakeBodygroupCombinations)
+		{
+			rawLODs.Reserve(vtxHeader.numLODs);
+			for (int lodIndex = 0; lodIndex < vtxHeader.numLODs; ++lodIndex)
 			{
-				//FMeshCleanSettings cleanSettings = FMeshCleanSettings::Default;
-				//cleanSettings.WeldVertices = true;
-				//FMeshUtils::Clean(localMeshDescription, cleanSettings);
+				rawLODs.Add(localMeshDatas[lodIndex].meshDescription);
 			}
+		}
 
-			// Copy to static mesh
-			FMeshDescription* meshDescription = staticMesh->CreateMeshDescription(lodIndex);
-			*meshDescription = localMeshDescription;
-			staticMesh->CommitMeshDescription(lodIndex);
+		for (int lodIndex = 0; lodIndex < vtxHeader.numLODs; ++lodIndex)
+		{
+			BuildStaticMeshLOD(staticMesh, localMeshDatas[lodIndex].meshDescription, lodIndex);
 
 			// Assign materials
 			for (int sectionIdx = 0; sectionIdx < localSectionDatas.Num(); ++sectionIdx)
@@ -873,11 +889,8 @@ UStaticMesh* UMDLFactory::ImportStaticMesh
 
 				// Convert from source coord system to unreal
 				TArray<FVector3f> transformedVertices;
-				transformedVertices.Reserve(section.Vertices.Num());
-				for (const FVector3f& originalVertex : section.Vertices)
-				{
-					transformedVertices.Add(SourceToUnreal.Position(originalVertex));
-				}
+				transformedVertices.SetNumUninitialized(section.Vertices.Num());
+				SourceToUnreal.Positions(section.Vertices, transformedVertices);
 				TArray<int> transformedFaceIndices;
 				transformedFaceIndices.Reserve(section.FaceIndices.Num());
 				for (int j = 0; j < section.FaceIndices.Num(); j += 3)
@@ -1004,6 +1017,70 @@ UStaticMesh* UMDLFactory::ImportStaticMesh
 			modelData->Skins.Add(skinMapping);
 		}
 	}
+
+	// Bake bodygroup combinations
+	if (rawLODs.Num() > 0)
+	{
+		TArray<FName> bodygroupOrder;
+		TArray<int> bodygroupSizes;
+		int combinationCount = 1;
+		for (const Valve::MDL::mstudiobodyparts_t* bodyPart : bodyParts)
+		{
+			bodygroupOrder.Add(FName(*bodyPart->GetName()));
+			bodygroupSizes.Add(FMath::Max(bodyPart->nummodels, 1));
+			combinationCount *= bodygroupSizes.Last();
+		}
+		const int maxCombinations = IHL2Editor::Get().GetConfig().Model.MaxBakedBodygroupCombinations;
+		if (combinationCount > 1 && combinationCount <= maxCombinations)
+		{
+			TMap<FName, int> sectionsByName;
+			for (int sectionIdx = 0; sectionIdx < localSectionDatas.Num(); ++sectionIdx)
+			{
+				sectionsByName.Add(localSectionDatas[sectionIdx].sectionName, sectionIdx);
+			}
+			modelData->BodygroupOrder = bodygroupOrder;
+			const FString variantPackageBasePath = inParent->GetPathName() + TEXT("_bodygroups/");
+			TArray<int> combination;
+			combination.Init(0, bodygroupOrder.Num());
+			for (int combinationIndex = 0; combinationIndex < combinationCount; ++combinationIndex)
+			{
+				// Decode the combination and gather the sections it shows
+				TSet<int> sections;
+				FString variantName = inName.ToString();
+				int remainder = combinationIndex;
+				for (int i = 0; i < bodygroupOrder.Num(); ++i)
+				{
+					combination[i] = remainder % bodygroupSizes[i];
+					remainder /= bodygroupSizes[i];
+					const FModelBodygroup& bodygroup = bodygroups[bodygroupOrder[i]];
+					if (bodygroup.Mappings.IsValidIndex(combination[i]))
+					{
+						sections.Append(bodygroup.Mappings[combination[i]].Sections);
+					}
+					variantName.Appendf(TEXT("_%d"), combination[i]);
+				}
+
+				UPackage* variantPackage = CreatePackage(*(variantPackageBasePath + variantName));
+				UStaticMesh* variantMesh = CreateStaticMesh(variantPackage, FName(*variantName), flags);
+				if (variantMesh == nullptr) { continue; }
+				BakeStaticMeshVariant(staticMesh, variantMesh, rawLODs, sectionsByName, sections);
+
+				FModelBodygroupVariant& variant = modelData->BakedVariants.AddDefaulted_GetRef();
+				variant.Combination = combination;
+				variant.Mesh = variantMesh;
+			}
+
+			// Every variant carries the same model data, so bodygroups and skins can be applied whichever mesh is showing
+			for (const FModelBodygroupVariant& variant : modelData->BakedVariants)
+			{
+				variant.Mesh->AddAssetUserData(DuplicateObject<UHL2ModelData>(modelData, variant.Mesh));
+				variant.Mesh->PostEditChange();
+				FAssetRegistryModule::AssetCreated(variant.Mesh);
+				variant.Mesh->MarkPackageDirty();
+			}
+		}
+	}
+
 	if (modelData != nullptr)
 	{
 		modelData->PostEditChange();
@@ -1013,6 +1090,116 @@ UStaticMesh* UMDLFactory::ImportStaticMesh
 	return staticMesh;
 }
 
+void UMDLFactory::BuildStaticMeshLOD(UStaticMesh* staticMesh, FMeshDescription& localMeshDescription, int lodIndex)
+{
+	// Setup source model
+	FStaticMeshSourceModel& sourceModel = staticMesh->AddSourceModel();
+	FMeshBuildSettings& settings = sourceModel.BuildSettings;
+	settings.bRecomputeNormals = false;
+	settings.bRecomputeTangents = false;
+	settings.bGenerateLightmapUVs = false;
+	settings.SrcLightmapIndex = 0;
+	settings.DstLightmapIndex = 1;
+	settings.bRemoveDegenerates = false;
+	settings.bUseFullPrecisionUVs = true;
+	settings.MinLightmapResolution = 64;
+	sourceModel.ScreenSize.Default = FMath::Pow(0.5f, lodIndex + 1.0f);
+
+	// Prepare our mesh description
+	FMeshUtils::Clean(localMeshDescription);
+
+	// Generate lightmap coords
+	{
+		localMeshDescription.VertexInstanceAttributes().SetAttributeChannelCount(MeshAttribute::VertexInstance::TextureCoordinate, 2);
+		FOverlappingCorners overlappingCorners;
+		FStaticMeshOperations::FindOverlappingCorners(overlappingCorners, localMeshDescription, 0.00001f);
+		FStaticMeshOperations::CreateLightMapUVLayout(localMeshDescription, settings.SrcLightmapIndex, settings.DstLightmapIndex, settings.MinLightmapResolution, ELightmapUVVersion::Latest, overlappingCorners);
+	}
+
+	// Clean again but this time weld - we do weld after lightmap uv layout because welded vertices sometimes break that algorithm for whatever reason
+	{
+		//FMeshCleanSettings cleanSettings = FMeshCleanSettings::Default;
+		//cleanSettings.WeldVertices = true;
+		//FMeshUtils::Clean(localMeshDescription, cleanSettings);
+	}
+
+	// Copy to static mesh
+	FMeshDescription* meshDescription = staticMesh->CreateMeshDescription(lodIndex);
+	*meshDescription = localMeshDescription;
+	staticMesh->CommitMeshDescription(lodIndex);
+}
+
+void UMDLFactory::BakeStaticMeshVariant(UStaticMesh* baseMesh, UStaticMesh* variantMesh, const TArray<FMeshDescription>& rawLODs, const TMap<FName, int>& sectionsByName, const TSet<int>& sections)
+{
+	variantMesh->SetLightMapResolution(baseMesh->GetLightMapResolution());
+
+	// Keep every material slot so that skins map onto the same slot indices as the base mesh
+	variantMesh->SetStaticMaterials(baseMesh->GetStaticMaterials());
+
+	for (int lodIndex = 0; lodIndex < rawLODs.Num(); ++lodIndex)
+	{
+		// Strip every poly group belonging to a section that the combination doesn't show
+		FMeshDescription lodMeshDescription = rawLODs[lodIndex];
+		TPolygonGroupAttributesRef<FName> polyGroupMaterial = FStaticMeshAttributes(lodMeshDescription).GetPolygonGroupMaterialSlotNames();
+		TArray<FPolygonGroupID> strippedPolyGroups;
+		for (const FPolygonGroupID polyGroupID : lodMeshDescription.PolygonGroups().GetElementIDs())
+		{
+			const int* sectionIdx = sectionsByName.Find(polyGroupMaterial[polyGroupID]);
+			if (sectionIdx == nullptr || !sections.Contains(*sectionIdx))
+			{
+				strippedPolyGroups.Add(polyGroupID);
+			}
+		}
+		for (const FPolygonGroupID polyGroupID : strippedPolyGroups)
+		{
+			TArray<FPolygonID> polyIDs(lodMeshDescription.GetPolygonGroupPolygonIDs(polyGroupID));
+			TArray<FEdgeID> orphanedEdges;
+			TArray<FVertexInstanceID> orphanedVertexInstances;
+			for (const FPolygonID polyID : polyIDs)
+			{
+				lodMeshDescription.DeletePolygon(polyID, &orphanedEdges, &orphanedVertexInstances);
+			}
+			TArray<FVertexID> orphanedVertices;
+			for (const FEdgeID edgeID : orphanedEdges)
+			{
+				lodMeshDescription.DeleteEdge(edgeID, &orphanedVertices);
+			}
+			for (const FVertexInstanceID vertInstID : orphanedVertexInstances)
+			{
+				lodMeshDescription.DeleteVertexInstance(vertInstID, &orphanedVertices);
+			}
+			for (const FVertexID vertID : orphanedVertices)
+			{
+				lodMeshDescription.DeleteVertex(vertID);
+			}
+			lodMeshDescription.DeletePolygonGroup(polyGroupID);
+		}
+		FElementIDRemappings remappings;
+		lodMeshDescription.Compact(remappings);
+
+		BuildStaticMeshLOD(variantMesh, lodMeshDescription, lodIndex);
+
+		// Map the remaining poly groups back onto their material slots
+		TPolygonGroupAttributesRef<FName> builtPolyGroupMaterial = FStaticMeshAttributes(lodMeshDescription).GetPolygonGroupMaterialSlotNames();
+		int meshSectionIdx = 0;
+		for (const FPolygonGroupID polyGroupID : lodMeshDescription.PolygonGroups().GetElementIDs())
+		{
+			variantMesh->GetSectionInfoMap().Set(lodIndex, meshSectionIdx++, FMeshSectionInfo(sectionsByName[builtPolyGroupMaterial[polyGroupID]]));
+		}
+	}
+
+	// Share the collision of the base mesh
+	if (baseMesh->GetBodySetup() != nullptr)
+	{
+		variantMesh->bCustomizedCollision = baseMesh->bCustomizedCollision;
+		variantMesh->CreateBodySetup();
+		variantMesh->GetBodySetup()->CopyBodyPropertiesFrom(baseMesh->GetBodySetup());
+	}
+
+	variantMesh->SetLightMapCoordinateIndex(1);
+	variantMesh->Build();
+}
+
 USkeletalMesh* UMDLFactory::ImportSkeletalMesh
 (
 	UObject* inParent, FName inName, UObject* inSkeletonParent, FName inSkeletonName, UObject* inPhysAssetParent, FName inPhysAssetName, EObjectFlags flags,
@@ -2167,6 +2354,44 @@ void UMDLFactory::ImportSequences(const Valve::MDL::studiohdr_t& header, USkelet
 	}*/
 }
 
+bool UMDLFactory::IsNeverAnimated(const Valve::MDL::studiohdr_t& header, const Valve::VVD::vertexFileHeader_t& vvdHeader)
+{
+	// Sequences of included models could animate us, and any sequence beyond the idle one implies animation
+	if (header.includemodel_count > 0) { return false; }
+	if (header.localseq_count > 1) { return false; }
+
+	// Bodygroup choices need their sections kept apart
+	TArray<const Valve::MDL::mstudiobodyparts_t*> bodyParts;
+	header.GetBodyParts(bodyParts);
+	for (const Valve::MDL::mstudiobodyparts_t* bodyPart : bodyParts)
+	{
+		if (bodyPart->nummodels > 1) { return false; }
+	}
+
+	// Every animation must only hold the rest pose
+	const bool singleBone = header.bone_count <= 1;
+	TArray<const Valve::MDL::mstudioanimdesc_t*> anims;
+	header.GetLocalAnims(anims);
+	for (const Valve::MDL::mstudioanimdesc_t* anim : anims)
+	{
+		if (anim->HasFlag(Valve::MDL::mstudioanimdesc_flag::ALLZEROS)) { continue; }
+		if (singleBone && anim->numframes <= 1) { continue; }
+		return false;
+	}
+	if (singleBone) { return true; }
+
+	// With more than one bone, each vertex must follow exactly one
+	const int vertCount = vvdHeader.numLODVertexes[0];
+	for (int i = 0; i < vertCount; ++i)
+	{
+		Valve::VVD::mstudiovertex_t vertex;
+		FVector4f tangent;
+		vvdHeader.GetVertex(i, vertex, tangent);
+		if (vertex.m_BoneWeights.numbones > 1) { return false; }
+	}
+	return true;
+}
+
 bool UMDLFactory::SkeletonHasMultipleRoots(const Valve::MDL::studiohdr_t& header)
 {
 	TArray<const Valve::MDL::mstudiobone_t*> bones;
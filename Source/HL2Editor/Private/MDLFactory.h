@@ -41,6 +41,10 @@ public:
 	UPROPERTY()
 	TArray<UAnimSequence*> Animations;
 
+	/** A static mesh imported alongside the skeletal mesh when the model can never visibly animate. */
+	UPROPERTY()
+	UStaticMesh* RigidStaticMesh = nullptr;
+
 };
 
 USTRUCT()
@@ -131,6 +135,19 @@ private:
 		FFeedbackContext* warn
 	);
 
+	/** Adds a source model for the lod to the static mesh, prepares the mesh description and commits it. */
+	static void BuildStaticMeshLOD(UStaticMesh* staticMesh, FMeshDescription& localMeshDescription, int lodIndex);
+
+	/** Builds a static mesh from the lods of a base mesh, keeping only the given sections. */
+	static void BakeStaticMeshVariant(UStaticMesh* baseMesh, UStaticMesh* variantMesh, const TArray<FMeshDescription>& rawLODs, const TMap<FName, int>& sectionsByName, const TSet<int>& sections);
+
+	/**
+	 * Gets whether the model always shows its rest pose, so it can be imported as a static mesh without visible difference.
+	 * True when the model includes no other models, has no bodygroup choices and at most one sequence,
+	 * and either has a single bone posed by single frame animations, or is rigidly skinned with animations holding no data.
+	 */
+	static bool IsNeverAnimated(const Valve::MDL::studiohdr_t& header, const Valve::VVD::vertexFileHeader_t& vvdHeader);
+
 	static bool SkeletonHasMultipleRoots(const Valve::MDL::studiohdr_t& header);
 
 	static bool SkeletonHasMultipleRoots(const TArray<const Valve::MDL::mstudiobone_t*>& bones);
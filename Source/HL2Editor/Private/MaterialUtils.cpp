@@ -216,6 +216,7 @@ bool FMaterialUtils::SetFromVMT(UMaterialInstanceConstant* mtl, const UValveDocu
 	if (vmtMaterial != nullptr)
 	{
 		vmtMaterial->vmtTextures = vmtTextures;
+		IHL2Runtime::Get().NotifyMaterialTexturesChanged(vmtMaterial);
 	}
 
 	// Update static parameters
@@ -1,5 +1,6 @@
 #include "BSPFile.hpp"
 #include <iostream>
+#include <cstring>
 using namespace Valve;
 using namespace BSP;
 
@@ -32,9 +33,9 @@ bool BSPFile::parse( const std::string& bsp_directory, const std::string& bsp_fi
             return false;
         }
 
-		/*if ( !parse_vis( bsp_binary ) ) {
+		if ( !parse_vis( bsp_binary ) ) {
 			return false;
-		}*/
+		}
 
 		parse_lump_data( bsp_binary, LUMP_ENTITIES, m_Entities );
 
@@ -71,6 +72,11 @@ bool BSPFile::parse( const std::string& bsp_directory, const std::string& bsp_fi
 
 		parse_lump_data(bsp_binary, LUMP_CUBEMAPS, m_Cubemaps);
 
+		if ( !parse_worldlights( bsp_binary, LUMP_WORLDLIGHTS, m_Worldlights )
+			|| !parse_worldlights( bsp_binary, LUMP_WORLDLIGHTS_HDR, m_WorldlightsHDR ) ) {
+			return false;
+		}
+
 		if ( !parse_gamelumps( bsp_binary )
 			|| !parse_staticprops( bsp_binary ) ) {
 			return false;
@@ -88,36 +94,35 @@ bool BSPFile::parse( const std::string& bsp_directory, const std::string& bsp_fi
 bool BSPFile::parse_vis( std::ifstream& bsp_binary )
 {
 	try {
-		std::vector< char > data;
+		std::vector< uint8_t > data;
 		parse_lump_data( bsp_binary, LUMP_VISIBILITY, data );
-		const int* start = (const int*)&data[0];
-
-		const int numClusters = *start;
-		
-		for (int clusterIndex = 0; clusterIndex < numClusters; ++clusterIndex) {
-			std::vector< int > visibleClusters;
-			int v = start[(clusterIndex << 1) + 1];
-
-			for (int c = 0; c < numClusters; v++) {
+		if ( data.size() < sizeof( int32_t ) ) {
+			return true;
+		}
 
-				if (start[v] == 0) {
-					v++;
-					c += 8 * start[v];
+		/// dvis_t: numclusters followed by a [PVS, PAS] byte offset pair per cluster
+		const int32_t* header = reinterpret_cast< const int32_t* >( data.data() );
+		const int32_t num_clusters = header[ 0 ];
+
+		m_Visibility = std::vector< std::vector< int > >( num_clusters );
+		for ( int32_t cluster_index = 0; cluster_index < num_clusters; ++cluster_index ) {
+			auto& visible_clusters = m_Visibility.at( cluster_index );
+			size_t v = static_cast< size_t >( header[ 1 + ( cluster_index << 1 ) ] );
+
+			/// run-length encoded bitfield, a zero byte is followed by a count of zero bytes to skip
+			for ( int32_t c = 0; c < num_clusters && v < data.size(); ++v ) {
+				if ( data[ v ] == 0 ) {
+					++v;
+					c += 8 * ( v < data.size() ? data[ v ] : 0 );
+					continue;
 				}
-				else {
-					for (char bit = 1; bit != 0; bit *= 2, c++) {
-						if (start[v] & bit) {
-							visibleClusters.push_back(c);
-						}
+				for ( int32_t bit = 0; bit < 8 && c < num_clusters; ++bit, ++c ) {
+					if ( data[ v ] & ( 1 << bit ) ) {
+						visible_clusters.push_back( c );
 					}
 				}
-
 			}
-
-			m_Visibility.push_back(visibleClusters);
 		}
-
-
 	}
 	catch (const std::exception& e) {
 		print_exception("parse_vis", e);
@@ -347,34 +352,102 @@ bool BSPFile::parse_staticprops( std::ifstream& bsp_binary )
 		int numStaticProps;
 		bsp_binary.read( (char*)& numStaticProps, sizeof( int ) );
 
+		if ( numStaticProps <= 0 ) {
+			return true;
+		}
+
+		/// version 10 was used by two different layouts, so the record size decides
+		const auto props_offset = static_cast< int >( bsp_binary.tellg() ) - lump.m_Fileofs;
+		const auto stride = static_cast< size_t >( ( lump_size - props_offset ) / numStaticProps );
+		bool has_dxlevels = false, has_cpulevels = false, has_diffuse = false, has_x360 = false, has_flagsex = false, has_scale = false;
 		switch ( lump.m_Version ) {
 			case 4:
-
-				m_Staticprops_v4 = std::vector< StaticProp_v4_t >( numStaticProps );
-				bsp_binary.read( reinterpret_cast<char*>( m_Staticprops_v4.data() ), sizeof( StaticProp_v4_t ) * numStaticProps );
-
-				break;
 			case 5:
-
-				m_Staticprops_v5 = std::vector< StaticProp_v5_t >( numStaticProps );
-				bsp_binary.read( reinterpret_cast<char*>( m_Staticprops_v5.data() ), sizeof( StaticProp_v5_t ) * numStaticProps );
-
 				break;
 			case 6:
-
-				m_Staticprops_v6 = std::vector< StaticProp_v6_t >( numStaticProps );
-				bsp_binary.read( reinterpret_cast<char*>( m_Staticprops_v6.data() ), sizeof( StaticProp_v6_t ) * numStaticProps );
-
+				has_dxlevels = true;
+				break;
+			case 7:
+				has_dxlevels = has_diffuse = true;
+				break;
+			case 8:
+				has_cpulevels = has_diffuse = true;
+				break;
+			case 9:
+				has_cpulevels = has_diffuse = has_x360 = true;
+				break;
+			case 10:
+				/// source 2013 appends lightmap resolution to v6, csgo appends extended flags to v9
+				has_dxlevels = stride == 72;
+				has_cpulevels = has_diffuse = has_x360 = has_flagsex = !has_dxlevels;
+				break;
+			case 11:
+				has_cpulevels = has_diffuse = has_x360 = has_flagsex = has_scale = true;
 				break;
-            case 10:
-
-                m_Staticprops_v10 = std::vector< StaticProp_v10_t >(numStaticProps);
-                bsp_binary.read(reinterpret_cast<char*>(m_Staticprops_v10.data()), sizeof(StaticProp_v10_t) * numStaticProps);
-
-                break;
 			default:
 				throw std::exception("Unsupported static prop lump version");
 		}
+		if ( stride < sizeof( StaticProp_v4_t ) ) {
+			throw std::exception("Static prop lump is too small for its version");
+		}
+
+		std::vector< char > records( stride * numStaticProps );
+		bsp_binary.read( records.data(), records.size() );
+
+		m_Staticprops = std::vector< StaticProp_t >( numStaticProps );
+		for ( int i = 0; i < numStaticProps; ++i ) {
+			const char* record = records.data() + stride * i;
+			auto& prop = m_Staticprops[ i ];
+
+			StaticProp_v4_t prefix;
+			std::memcpy( &prefix, record, sizeof( StaticProp_v4_t ) );
+			prop.m_Origin = prefix.m_Origin;
+			prop.m_Angles = prefix.m_Angles;
+			prop.m_LightingOrigin = prefix.m_LightingOrigin;
+			prop.m_FadeMinDist = prefix.m_FadeMinDist;
+			prop.m_FadeMaxDist = prefix.m_FadeMaxDist;
+			prop.m_Skin = prefix.m_Skin;
+			prop.m_PropType = prefix.m_PropType;
+			prop.m_FirstLeaf = prefix.m_FirstLeaf;
+			prop.m_LeafCount = prefix.m_LeafCount;
+			prop.m_Solid = prefix.m_Solid;
+			prop.m_Flags = prefix.m_Flags;
+			prop.m_ForcedFadeScale = 1.f;
+			prop.m_UniformScale = 1.f;
+			prop.m_FlagsEx = 0;
+			prop.m_DiffuseModulation = { 255, 255, 255, 255 };
+
+			/// the fields after the common prefix, in on-disk order
+			size_t offset = sizeof( StaticProp_v4_t );
+			if ( lump.m_Version >= 5 ) {
+				std::memcpy( &prop.m_ForcedFadeScale, record + offset, sizeof( float ) );
+				offset += sizeof( float );
+			}
+			if ( has_dxlevels ) {
+				offset += sizeof( uint16_t ) * 2;
+			}
+			if ( has_cpulevels ) {
+				offset += sizeof( uint8_t ) * 4;
+			}
+			if ( has_diffuse ) {
+				std::memcpy( prop.m_DiffuseModulation.data(), record + offset, 4 );
+				offset += 4;
+			}
+			if ( has_x360 ) {
+				offset += 4; /// bool padded to 4 bytes
+			}
+			if ( has_flagsex ) {
+				std::memcpy( &prop.m_FlagsEx, record + offset, sizeof( uint32_t ) );
+				offset += sizeof( uint32_t );
+			}
+			if ( has_scale ) {
+				std::memcpy( &prop.m_UniformScale, record + offset, sizeof( float ) );
+				offset += sizeof( float );
+			}
+			if ( offset > stride ) {
+				throw std::exception("Static prop record is smaller than its version requires");
+			}
+		}
 	}
 	catch (const std::exception& e) {
 		print_exception("parse_gamelumps", e);
@@ -383,6 +456,49 @@ bool BSPFile::parse_staticprops( std::ifstream& bsp_binary )
 	return true;
 }
 
+bool BSPFile::parse_worldlights( std::ifstream& bsp_binary, const BSP::eLumpIndex lump_index, std::vector< BSP::dworldlight_t >& buffer )
+{
+	try {
+		auto& lump = m_BSPHeader.m_Lumps.at( static_cast< size_t >( lump_index ) );
+		if ( lump.m_Version != 0 ) {
+			parse_lump_data( bsp_binary, lump_index, buffer );
+			return true;
+		}
+
+		/// version 0 lacks the flags field, upgrade it to the current layout
+		std::vector< dworldlight_version0_t > lights;
+		parse_lump_data( bsp_binary, lump_index, lights );
+
+		buffer = std::vector< dworldlight_t >( lights.size() );
+		for ( size_t i = 0; i < lights.size(); ++i ) {
+			const auto& old_light = lights[ i ];
+			auto& new_light = buffer[ i ];
+
+			new_light.m_Origin = old_light.m_Origin;
+			new_light.m_Intensity = old_light.m_Intensity;
+			new_light.m_Normal = old_light.m_Normal;
+			new_light.m_Cluster = old_light.m_Cluster;
+			new_light.m_Type = old_light.m_Type;
+			new_light.m_Style = old_light.m_Style;
+			new_light.m_Stopdot = old_light.m_Stopdot;
+			new_light.m_Stopdot2 = old_light.m_Stopdot2;
+			new_light.m_Exponent = old_light.m_Exponent;
+			new_light.m_Radius = old_light.m_Radius;
+			new_light.m_ConstantAttn = old_light.m_ConstantAttn;
+			new_light.m_LinearAttn = old_light.m_LinearAttn;
+			new_light.m_QuadraticAttn = old_light.m_QuadraticAttn;
+			new_light.m_Texinfo = old_light.m_Texinfo;
+			new_light.m_Owner = old_light.m_Owner;
+			new_light.m_Flags = 0;
+		}
+	}
+	catch ( const std::exception& e ) {
+		print_exception( "parse_worldlights", e );
+		return false;
+	}
+	return true;
+}
+
 void BSPFile::print_exception( const std::string& function_name, const std::exception& e ) const
 {
     std::cout << "BSPFile::"
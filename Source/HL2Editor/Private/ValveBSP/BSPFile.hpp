@@ -127,12 +127,23 @@ namespace Valve {
 		BSP::dgamelump_t get_game_lump( const BSP::eGamelumpIndex gamelump_index ) const;
 
 		/**
-		 * @brief      Parse map static prop lumps.
+		 * @brief      Parse map static prop lumps, normalising every supported version (4 to 11) into m_Staticprops.
 		 *
 		 * @return     False if an exception got throwed, True otherwise.
 		 */
 		bool parse_staticprops( std::ifstream& bsp_binary );
         
+		/**
+		 * @brief      Parse map world lights, upgrading version 0 lumps to the current layout.
+		 *
+		 * @param      bsp_binary  The bsp binary
+		 * @param[in]  lump_index  The lump index, either LUMP_WORLDLIGHTS or LUMP_WORLDLIGHTS_HDR
+		 * @param      buffer      The buffer
+		 *
+		 * @return     False if an exception got throwed, True otherwise.
+		 */
+		bool parse_worldlights( std::ifstream& bsp_binary, const BSP::eLumpIndex lump_index, std::vector< BSP::dworldlight_t >& buffer );
+
         /**
          * @brief      Print function specific exception.
          *
@@ -179,17 +190,14 @@ namespace Valve {
 		std::vector< BSP::ddispvert_t >  m_Dispverts;
 		std::vector< BSP::ddisptri_t >   m_Disptris;
 		std::vector< BSP::dcubemapsample_t >   m_Cubemaps;
+		std::vector< BSP::dworldlight_t > m_Worldlights;
+		std::vector< BSP::dworldlight_t > m_WorldlightsHDR;
         std::vector< BSP::Polygon >      m_Polygons;
 		std::vector< BSP::dgamelump_t >  m_Gamelumps;
 		std::vector< BSP::StaticPropName_t >	m_StaticpropStringTable;
-		std::vector< BSP::StaticProp_v4_t >		m_Staticprops_v4;
-		std::vector< BSP::StaticProp_v5_t >		m_Staticprops_v5;
-		std::vector< BSP::StaticProp_v6_t >		m_Staticprops_v6;
-        std::vector< BSP::StaticProp_v10_t >	m_Staticprops_v10;
+		std::vector< BSP::StaticProp_t >		m_Staticprops;
     };
 
-    constexpr int blah = sizeof(BSP::StaticProp_v10_t);
-
     template< typename T >
     void BSPFile::parse_lump_data( std::ifstream& bsp_binary, const BSP::eLumpIndex lump_index, std::vector< T >& buffer ) const
     {
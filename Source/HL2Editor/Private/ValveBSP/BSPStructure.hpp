@@ -63,7 +63,8 @@ namespace Valve { namespace BSP {
         LUMP_OVERLAYS                       = 45,
         LUMP_LEAFMINDISTTOWATER             = 46,
         LUMP_FACE_MACRO_TEXTURE_INFO        = 47,
-        LUMP_DISP_TRIS                      = 48
+        LUMP_DISP_TRIS                      = 48,
+        LUMP_WORLDLIGHTS_HDR                = 54
     };
 
 	enum eGamelumpIndex : int
@@ -337,33 +338,102 @@ namespace Valve { namespace BSP {
 		Vector3         m_LightingOrigin;    // for lighting
 	};
 
-    constexpr int StaticProp_v4_size = sizeof(StaticProp_v4_t);
+    constexpr int StaticProp_v4_size = sizeof(StaticProp_v4_t); /// common prefix of every lump version
 
-	class StaticProp_v5_t : public StaticProp_v4_t
+	enum eStaticPropFlags : uint8_t
+	{
+		STATIC_PROP_FLAG_FADES             = 0x1,
+		STATIC_PROP_USE_LIGHTING_ORIGIN    = 0x2,
+		STATIC_PROP_NO_DRAW                = 0x4,  // computed at run time based on dx level
+		STATIC_PROP_IGNORE_NORMALS         = 0x8,
+		STATIC_PROP_NO_SHADOW              = 0x10,
+		STATIC_PROP_SCREEN_SPACE_FADE      = 0x20, // fade distances are pixel sizes on screen rather than world distances
+		STATIC_PROP_NO_PER_VERTEX_LIGHTING = 0x40,
+		STATIC_PROP_NO_SELF_SHADOWING      = 0x80
+	};
+
+	/// Normalised static prop, filled from whichever lump version is on disk.
+	/// Fields missing from older versions hold the engine defaults.
+	class StaticProp_t
 	{
 	public:
-		float           m_ForcedFadeScale;   // fade distance scale
+		Vector3         m_Origin;            // origin
+		Vector3         m_Angles;            // orientation (pitch yaw roll)
+		Vector3         m_LightingOrigin;    // for lighting
+		float           m_FadeMinDist;
+		float           m_FadeMaxDist;
+		float           m_ForcedFadeScale;   // fade distance scale, v5+
+		float           m_UniformScale;      // v11+
+		int             m_Skin;              // model skin numbers
+		uint32_t        m_FlagsEx;           // extended flags, v10 (CS:GO)+
+		uint16_t        m_PropType;          // index into model name dictionary
+		uint16_t        m_FirstLeaf;         // index into leaf array
+		uint16_t        m_LeafCount;
+		uint8_t         m_Solid;             // solidity type
+		uint8_t         m_Flags;
+		array< uint8_t, 4 > m_DiffuseModulation; // per instance color and alpha modulation, v7+
 	};
 
-    constexpr int StaticProp_v5_size = sizeof(StaticProp_v5_t);
+	enum emittype_t : int
+	{
+		emit_surface,		// 90 degree spotlight
+		emit_point,			// simple point light source
+		emit_spotlight,		// spotlight with penumbra
+		emit_skylight,		// directional light with no falloff (surface must trace to SKY texture)
+		emit_quakelight,	// linear falloff, non-lambertian
+		emit_skyambient		// spherical light source with no falloff (surface must trace to SKY texture)
+	};
+
+	static constexpr int32_t DWL_FLAGS_INAMBIENTCUBE = 0x0001; // This says that the light was put into the per-leaf ambient cubes.
 
-	class StaticProp_v6_t : public StaticProp_v5_t
+	class dworldlight_version0_t
 	{
 	public:
-		unsigned short  m_MinDXLevel;        // minimum DirectX version to be visible
-		unsigned short  m_MaxDXLevel;        // maximum DirectX version to be visible
+		Vector3         m_Origin;
+		Vector3         m_Intensity;
+		Vector3         m_Normal;            // for surfaces and spotlights
+		int             m_Cluster;
+		emittype_t      m_Type;
+		int             m_Style;
+		float           m_Stopdot;           // start of penumbra for emit_spotlight
+		float           m_Stopdot2;          // end of penumbra for emit_spotlight
+		float           m_Exponent;
+		float           m_Radius;            // cutoff distance
+		// falloff for emit_spotlight + emit_point:
+		// 1 / (constant_attn + linear_attn * dist + quadratic_attn * dist^2)
+		float           m_ConstantAttn;
+		float           m_LinearAttn;
+		float           m_QuadraticAttn;
+		int             m_Texinfo;
+		int             m_Owner;             // entity that this light it relative to
 	};
 
-    constexpr int StaticProp_v6_size = sizeof(StaticProp_v6_t);
+	constexpr int dworldlight_version0_size = sizeof(dworldlight_version0_t);
 
-    class StaticProp_v10_t : public StaticProp_v6_t
-    {
-    public:
-        int             m_LightmapResolutionX;
-        int             m_LightmapResolutionY;
-    };
+	class dworldlight_t
+	{
+	public:
+		Vector3         m_Origin;
+		Vector3         m_Intensity;
+		Vector3         m_Normal;            // for surfaces and spotlights
+		int             m_Cluster;
+		emittype_t      m_Type;
+		int             m_Style;
+		float           m_Stopdot;           // start of penumbra for emit_spotlight
+		float           m_Stopdot2;          // end of penumbra for emit_spotlight
+		float           m_Exponent;
+		float           m_Radius;            // cutoff distance
+		// falloff for emit_spotlight + emit_point:
+		// 1 / (constant_attn + linear_attn * dist + quadratic_attn * dist^2)
+		float           m_ConstantAttn;
+		float           m_LinearAttn;
+		float           m_QuadraticAttn;
+		int             m_Flags;             // combination of the DWL_FLAGS_ defines
+		int             m_Texinfo;
+		int             m_Owner;             // entity that this light it relative to
+	};
 
-    constexpr int StaticProp_v10_size = sizeof(StaticProp_v10_t);
+	constexpr int dworldlight_size = sizeof(dworldlight_t);
 
     class VPlane
     {
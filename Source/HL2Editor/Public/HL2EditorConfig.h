@@ -4,6 +4,8 @@
 
 #include "HL2EditorConfig.generated.h"
 
+// Map entities are imported in one undo transaction with selection changes batched, and the imported entities are selected together at the end.
+// Level actor added notifications still fire once per spawned actor, as the engine offers no way to suspend them for a batch.
 USTRUCT()
 struct FHL2EditorBSPConfig
 {
@@ -19,6 +21,21 @@ public:
 	UPROPERTY()
 	int CellSize = 2048;
 
+	// The number of material sections a cell may have before compatible sections are merged into texture atlases.
+	// Zero or less only reports the section counts.
+	UPROPERTY()
+	int MaxSectionsPerCell = 24;
+
+	// Materials whose base textures may be packed into a shared atlas when a cell is over budget, e.g. "decals/*". Empty allows any material.
+	// Only materials whose shader and parameters match apart from the base texture are merged, and only where no face repeats the texture.
+	// Base textures must be uncompressed BGRA8 with dimensions divisible by 8, others are never atlased.
+	UPROPERTY()
+	TArray<FString> AtlasCompatibleMaterials;
+
+	// The XY size of each atlas texture
+	UPROPERTY()
+	int AtlasSize = 2048;
+
 	// Whether to merge displacements and then split into cells like map brush geometry
 	UPROPERTY()
 	bool UseDisplacementCells = true;
@@ -42,6 +59,34 @@ public:
 	UPROPERTY()
 	bool EmitReflectionCaptures = false;
 
+	// Whether to use the fade distances mappers set on static props as cull distances.
+	UPROPERTY()
+	bool UseStaticPropFadeDistances = true;
+
+	// The size in pixels on a 1080p screen below which static props without fade distances are culled.
+	// Zero or less never culls those props, leaving them as the map compiled them. Off by default.
+	UPROPERTY()
+	float StaticPropCullScreenSize = 0.0f;
+
+	// Whether to emit lights from the compiled worldlights lump.
+	// Most light and light_spot entities are removed from the entity lump by vbsp, so this is the only way to import them.
+	UPROPERTY()
+	bool EmitWorldLights = true;
+
+	// Whether to prefer the HDR worldlights lump over the LDR one when the map has both.
+	UPROPERTY()
+	bool PreferHDRWorldLights = true;
+
+	// The multiplier applied to the peak channel of a worldlight's intensity to get the unreal light intensity.
+	UPROPERTY()
+	float WorldLightIntensityScale = 1.0f;
+
+	// Whether to resolve the targets of logic outputs to the imported entities up front, instead of by name each time they fire.
+	// Targets with wildcards or special names are always resolved when fired, as are names that match no imported entity.
+	// Once an entity spawns or is renamed under a resolved name during play, outputs to that name fall back to finding their targets by name.
+	UPROPERTY()
+	bool ResolveLogicOutputTargets = true;
+
 	// Whether to prevent dependency on HL2Runtime.
 	// If true, a limited set of unreal built-in entities will be used.
 	// The map will not function as a HL2 playable map, but can be exported and used in other projects.
@@ -77,6 +122,23 @@ public:
 	// This is helpful if you're just using the plugin to import static and skeletal meshes without caring about functionality.
 	UPROPERTY()
 	bool Portable = false;
+
+	// Whether to bake each bodygroup combination of a static prop into its own static mesh, next to the model in a "_bodygroups" folder.
+	// Setting a bodygroup then swaps to the baked mesh, which only has the triangles and sections of that combination.
+	// Ignored when Portable is set.
+	UPROPERTY()
+	bool BakeBodygroupCombinations = false;
+
+	// The most bodygroup combinations a static prop may have for them to be baked.
+	// Props with more combinations than this keep a single mesh.
+	UPROPERTY()
+	int MaxBakedBodygroupCombinations = 8;
+
+	// Whether to also import a static mesh for animated models that can never visibly animate, next to the model with a "_static" suffix.
+	// That is, models with no included animations, no bodygroup choices, at most one sequence, and animation data that only holds the rest pose.
+	// Portable map imports use it for props that no input or keyvalue animates.
+	UPROPERTY()
+	bool ImportRigidStaticMeshes = true;
 };
 
 USTRUCT()
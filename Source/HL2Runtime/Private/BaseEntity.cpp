@@ -1,8 +1,11 @@
 #include "BaseEntity.h"
 #include "BaseEntityComponent.h"
 #include "IHL2Runtime.h"
-#include "TimerManager.h"
 #include "VBSPInfo.h"
+#include "HL2EntitySubsystem.h"
+#include "HL2EventQueueSubsystem.h"
+#include "HL2PVSTickSubsystem.h"
+#include "HL2IOTelemetry.h"
 
 DEFINE_LOG_CATEGORY(LogHL2IOSystem);
 
@@ -36,6 +39,85 @@ void ABaseEntity::BeginPlay()
 {
 	Super::BeginPlay();
 	ResetLogicOutputs();
+	UHL2PVSTickSubsystem* pvsTickSubsystem = GetWorld()->GetSubsystem<UHL2PVSTickSubsystem>();
+	if (pvsTickSubsystem != nullptr)
+	{
+		pvsTickSubsystem->RegisterEntity(this);
+	}
+}
+
+void ABaseEntity::EndPlay(const EEndPlayReason::Type endPlayReason)
+{
+	UWorld* world = GetWorld();
+	UHL2PVSTickSubsystem* pvsTickSubsystem = world != nullptr ? world->GetSubsystem<UHL2PVSTickSubsystem>() : nullptr;
+	if (pvsTickSubsystem != nullptr)
+	{
+		pvsTickSubsystem->UnregisterEntity(this);
+	}
+	Super::EndPlay(endPlayReason);
+}
+
+void ABaseEntity::PostRegisterAllComponents()
+{
+	Super::PostRegisterAllComponents();
+	UWorld* world = GetWorld();
+	UHL2EntitySubsystem* entitySubsystem = world != nullptr ? world->GetSubsystem<UHL2EntitySubsystem>() : nullptr;
+	if (entitySubsystem != nullptr)
+	{
+		entitySubsystem->RegisterEntity(this);
+	}
+}
+
+void ABaseEntity::PostUnregisterAllComponents()
+{
+	UWorld* world = GetWorld();
+	UHL2EntitySubsystem* entitySubsystem = world != nullptr ? world->GetSubsystem<UHL2EntitySubsystem>() : nullptr;
+	if (entitySubsystem != nullptr)
+	{
+		entitySubsystem->UnregisterEntity(this);
+	}
+	Super::PostUnregisterAllComponents();
+}
+
+#if WITH_EDITOR
+void ABaseEntity::PostEditChangeProperty(FPropertyChangedEvent& propertyChangedEvent)
+{
+	Super::PostEditChangeProperty(propertyChangedEvent);
+	if (propertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(ABaseEntity, TargetName))
+	{
+		SetTargetName(TargetName);
+	}
+
+	// Typed values are cached from the keyvalues, so any edit within the entity data invalidates them
+	if (propertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(ABaseEntity, EntityData))
+	{
+		EntityData.ResetTypedValues();
+	}
+}
+
+void ABaseEntity::PostEditChangeChainProperty(FPropertyChangedChainEvent& propertyChangedEvent)
+{
+	Super::PostEditChangeChainProperty(propertyChangedEvent);
+	const FEditPropertyChain::TDoubleLinkedListNode* memberNode = propertyChangedEvent.PropertyChain.GetActiveMemberNode();
+	if (memberNode != nullptr && memberNode->GetValue() != nullptr && memberNode->GetValue()->GetFName() == GET_MEMBER_NAME_CHECKED(ABaseEntity, EntityData))
+	{
+		EntityData.ResetTypedValues();
+	}
+}
+#endif
+
+void ABaseEntity::SetTargetName(const FName newTargetName)
+{
+	TargetName = newTargetName;
+
+	// Unregistered entities are indexed once their components register
+	if (!HasActorRegisteredAllComponents()) { return; }
+	UWorld* world = GetWorld();
+	UHL2EntitySubsystem* entitySubsystem = world != nullptr ? world->GetSubsystem<UHL2EntitySubsystem>() : nullptr;
+	if (entitySubsystem != nullptr)
+	{
+		entitySubsystem->RegisterEntity(this);
+	}
 }
 	
 
@@ -48,65 +130,132 @@ void ABaseEntity::BeginPlay()
  */
 bool ABaseEntity::FireInput(const FName inputName, const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
 {
-	UE_LOG(LogHL2IOSystem, Log, TEXT("Entity %s:%s receiving '%s' with %d args"), *TargetName.ToString(), *EntityData.Classname.ToString(), *inputName.ToString(), args.Num());
+	HL2_IO_SCOPE(HL2_FireInput);
+	INC_DWORD_STAT(STAT_HL2IO_InputsFired);
+	HL2_IO_RECORD(Input, this, inputName, caller);
+	HL2_IO_TRACE(TEXT("Entity %s:%s receiving '%s' with %d args"), *TargetName.ToString(), *EntityData.Classname.ToString(), *inputName.ToString(), args.Num());
 
-	// Handle basic inputs
-	static const FName inKill(TEXT("Kill"));
-	static const FName inKillHierarchy(TEXT("KillHierarchy"));
-	static const FName inAddOutput(TEXT("AddOutput"));
-	static const FName inFireUser1(TEXT("FireUser1"));
-	static const FName inFireUser2(TEXT("FireUser2"));
-	static const FName inFireUser3(TEXT("FireUser3"));
-	static const FName inFireUser4(TEXT("FireUser4"));
-	static const FName onFireUser1(TEXT("OnUser1"));
-	static const FName onFireUser2(TEXT("OnUser2"));
-	static const FName onFireUser3(TEXT("OnUser3"));
-	static const FName onFireUser4(TEXT("OnUser4"));
-	if (inputName == inKill || inputName == inKillHierarchy)
+	// Handle natively supported inputs
+	const FInputDispatchTable& dispatchTable = GetInputDispatchTable(GetClass());
+	const FNativeInputHandler* nativeHandler = dispatchTable.NativeHandlers.Find(inputName);
+	if (nativeHandler != nullptr)
 	{
-		Destroy();
-		return true;
+		const bool handled = (this->*(nativeHandler->Handler))(args, caller, activator);
+		if (!nativeHandler->PassThrough) { return handled; }
 	}
-	else if (inputName == inAddOutput)
+
+	// Let components handle it, a handler may add or remove components so iterate a copy
+	if (InputComponents.Num() > 0)
 	{
-		// Not yet supported!
-		return false;
+		const TArray<UBaseEntityComponent*, TInlineAllocator<4>> inputComponents(InputComponents);
+		for (UBaseEntityComponent* baseEntityComponent : inputComponents)
+		{
+			baseEntityComponent->OnInputFired(inputName, args, caller, activator);
+		}
 	}
-	else if (inputName == inFireUser1)
+
+	// Let derived blueprint handle it, only if it implements the event
+	if (dispatchTable.CallOnInputFired)
 	{
-		FireOutput(onFireUser1, args, this, caller);
-		return true;
+		OnInputFired(inputName, args, caller, activator);
 	}
-	else if (inputName == inFireUser2)
+
+	// Assume success - we're not bothering with having OnInputFired return a bool yet
+	return true;
+}
+
+void ABaseEntity::RegisterInputHandlers(TMap<FName, FNativeInputHandler>& handlers) const
+{
+	handlers.Add(TEXT("Kill"), &ABaseEntity::InputKill);
+	handlers.Add(TEXT("KillHierarchy"), &ABaseEntity::InputKill);
+	handlers.Add(TEXT("AddOutput"), &ABaseEntity::InputAddOutput);
+	handlers.Add(TEXT("CancelPending"), FNativeInputHandler(&ABaseEntity::InputCancelPending, true));
+	handlers.Add(TEXT("FireUser1"), &ABaseEntity::InputFireUser1);
+	handlers.Add(TEXT("FireUser2"), &ABaseEntity::InputFireUser2);
+	handlers.Add(TEXT("FireUser3"), &ABaseEntity::InputFireUser3);
+	handlers.Add(TEXT("FireUser4"), &ABaseEntity::InputFireUser4);
+}
+
+const ABaseEntity::FInputDispatchTable& ABaseEntity::GetInputDispatchTable(const UClass* entityClass)
+{
+	// Tables are built per class, blueprint classes take the native handlers of their native parent as they cannot add their own
+	// Entries are keyed weakly, so a class that is unloaded and a new class at the same address never share one
+	static TMap<TWeakObjectPtr<const UClass>, TUniquePtr<FInputDispatchTable>> dispatchTables;
+#if WITH_EDITOR
+	// Recompiling a blueprint may add or remove its implementation of OnInputFired, and always reinstances its default object
+	static const FDelegateHandle objectsReplacedHandle = FCoreUObjectDelegates::OnObjectsReplaced.AddLambda([](const TMap<UObject*, UObject*>&) { dispatchTables.Empty(); });
+#endif
+	check(IsInGameThread());
+	const TUniquePtr<FInputDispatchTable>* existingTable = dispatchTables.Find(entityClass);
+	if (existingTable != nullptr) { return **existingTable; }
+
+	TUniquePtr<FInputDispatchTable> dispatchTable = MakeUnique<FInputDispatchTable>();
+	const UClass* nativeClass = entityClass;
+	while (!nativeClass->HasAnyClassFlags(CLASS_Native)) { nativeClass = nativeClass->GetSuperClass(); }
+	if (nativeClass != entityClass)
 	{
-		FireOutput(onFireUser2, args, this, caller);
-		return true;
+		dispatchTable->NativeHandlers = GetInputDispatchTable(nativeClass).NativeHandlers;
 	}
-	else if (inputName == inFireUser3)
+	else
 	{
-		FireOutput(onFireUser3, args, this, caller);
-		return true;
+		nativeClass->GetDefaultObject<ABaseEntity>()->RegisterInputHandlers(dispatchTable->NativeHandlers);
 	}
-	else if (inputName == inFireUser4)
+
+	// Native classes other than our own might override the implementation of OnInputFired, blueprints only when they implement the event
+	const UFunction* onInputFired = entityClass->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(ABaseEntity, OnInputFired));
+	dispatchTable->CallOnInputFired = nativeClass != ABaseEntity::StaticClass() || (onInputFired != nullptr && !onInputFired->GetOwnerClass()->HasAnyClassFlags(CLASS_Native));
+
+	return *dispatchTables.Add(entityClass, MoveTemp(dispatchTable));
+}
+
+bool ABaseEntity::InputKill(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
+{
+	Destroy();
+	return true;
+}
+
+bool ABaseEntity::InputAddOutput(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
+{
+	// Not yet supported!
+	return false;
+}
+
+bool ABaseEntity::InputCancelPending(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
+{
+	UHL2EventQueueSubsystem* eventQueue = GetWorld()->GetSubsystem<UHL2EventQueueSubsystem>();
+	if (eventQueue != nullptr)
 	{
-		FireOutput(onFireUser4, args, this, caller);
-		return true;
+		eventQueue->CancelEvents(this);
 	}
-	else
-	{
-		// Let components handle it
-		for (UActorComponent* component : GetComponentsByClass(UBaseEntityComponent::StaticClass()))
-		{
-			UBaseEntityComponent* baseEntityComponent = CastChecked<UBaseEntityComponent>(component);
-			baseEntityComponent->OnInputFired(inputName, args, caller, activator);
-		}
+	return true;
+}
 
-		// Let derived blueprint handle it
-		OnInputFired(inputName, args, caller, activator);
+bool ABaseEntity::InputFireUser1(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
+{
+	static const FName onFireUser1(TEXT("OnUser1"));
+	FireOutput(onFireUser1, args, this, caller);
+	return true;
+}
 
-		// Assume success - we're not bothering with having OnInputFired return a bool yet
-		return true;
-	}
+bool ABaseEntity::InputFireUser2(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
+{
+	static const FName onFireUser2(TEXT("OnUser2"));
+	FireOutput(onFireUser2, args, this, caller);
+	return true;
+}
+
+bool ABaseEntity::InputFireUser3(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
+{
+	static const FName onFireUser3(TEXT("OnUser3"));
+	FireOutput(onFireUser3, args, this, caller);
+	return true;
+}
+
+bool ABaseEntity::InputFireUser4(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
+{
+	static const FName onFireUser4(TEXT("OnUser4"));
+	FireOutput(onFireUser4, args, this, caller);
+	return true;
 }
 
 /**
@@ -115,33 +264,44 @@ bool ABaseEntity::FireInput(const FName inputName, const TArray<FString>& args,
  */
 int ABaseEntity::FireOutput(const FName outputName, const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
 {
-	UE_LOG(LogHL2IOSystem, Log, TEXT("Entity %s:%s firing '%s' with %d args"), *TargetName.ToString(), *EntityData.Classname.ToString(), *outputName.ToString(), args.Num());
+	HL2_IO_SCOPE(HL2_FireOutput);
+	INC_DWORD_STAT(STAT_HL2IO_OutputsFired);
+	HL2_IO_RECORD(Output, this, outputName, caller);
+	HL2_IO_TRACE(TEXT("Entity %s:%s firing '%s' with %d args"), *TargetName.ToString(), *EntityData.Classname.ToString(), *outputName.ToString(), args.Num());
 
-	// Gather all relevant outputs to fire
-	TArray<FEntityLogicOutput> toFire;
-	for (int i = LogicOutputs.Num() - 1; i >= 0; --i)
+	// Gather all relevant outputs to fire, firing can re-enter and modify our outputs so they are copied out first
+	TArray<FEntityLogicOutput, TInlineAllocator<4>> toFire;
+	for (int i = 0; i < LogicOutputs.Num();)
 	{
 		const FEntityLogicOutput& logicOutput = LogicOutputs[i];
-		if (logicOutput.OutputName == outputName)
+		if (logicOutput.OutputName != outputName)
 		{
-			toFire.Insert(logicOutput, 0);
-			if (logicOutput.Once)
-			{
-				LogicOutputs.RemoveAt(i);
-			}
+			++i;
+			continue;
+		}
+		toFire.Add(logicOutput);
+		if (logicOutput.Once)
+		{
+			LogicOutputs.RemoveAt(i);
+		}
+		else
+		{
+			++i;
 		}
 	}
 
-	// Iterate all
-	int result = 0;
+	// Iterate all, delayed outputs are dropped if the world has no event queue but the rest still fire
+	UHL2EventQueueSubsystem* eventQueue = GetWorld()->GetSubsystem<UHL2EventQueueSubsystem>();
+	const UHL2EntitySubsystem* entitySubsystem = GetWorld()->GetSubsystem<UHL2EntitySubsystem>();
+	int firedCount = 0;
 	for (const FEntityLogicOutput& logicOutput : toFire)
 	{
-		// Prepare arguments
+		// Prepare arguments, args fill in any parameters the output left empty
 		TArray<FString> arguments = logicOutput.Params;
-		arguments.Reserve(args.Num());
+		arguments.Reserve(FMath::Max(args.Num(), arguments.Num()));
 		for (int i = 0; i < args.Num(); ++i)
 		{
-			if (i > arguments.Num())
+			if (i >= arguments.Num())
 			{
 				arguments.Add(args[i]);
 			}
@@ -150,32 +310,53 @@ int ABaseEntity::FireOutput(const FName outputName, const TArray<FString>& args,
 				arguments[i] = args[i];
 			}
 		}
-		arguments.Reserve(FMath::Max(args.Num(), logicOutput.Params.Num()));
 
-		// Setup pending fire
-		FPendingFireOutput pendingFireOutput;
-		pendingFireOutput.Output = logicOutput;
-		pendingFireOutput.Args = arguments;
-		pendingFireOutput.Caller = caller;
-		pendingFireOutput.Activator = activator;
+		// Targets resolved at import time are just dereferenced, anything else is looked up by name when it fires
+		// Once an entity has spawned or been renamed into the name during play, the resolved targets no longer cover it
+		const bool useResolvedTargets = logicOutput.TargetsResolved && (entitySubsystem == nullptr || !entitySubsystem->HasEntitiesRegisteredDuringPlay(logicOutput.TargetName));
+		TArray<ABaseEntity*, TInlineAllocator<4>> targets;
+		if (useResolvedTargets)
+		{
+			for (const TSoftObjectPtr<ABaseEntity>& resolvedTarget : logicOutput.ResolvedTargets)
+			{
+				ABaseEntity* target = resolvedTarget.Get();
+				if (target != nullptr) { targets.Add(target); }
+			}
+		}
 
 		// If the delay is zero, fire it immediately
 		if (logicOutput.Delay <= 0.0f)
 		{
-			FireOutputInternal(pendingFireOutput);
+			if (useResolvedTargets)
+			{
+				FireInputOnTargets(targets, logicOutput.InputName, arguments, caller);
+			}
+			else
+			{
+				FireOutputInternal(logicOutput.TargetName, logicOutput.InputName, arguments, caller, activator);
+			}
+			++firedCount;
+			continue;
+		}
+
+		// Otherwise hand it to the world's event queue
+		if (eventQueue == nullptr)
+		{
+			UE_LOG(LogHL2IOSystem, Warning, TEXT("Entity %s:%s dropped delayed output '%s' to %s.%s, the world has no event queue"), *TargetName.ToString(), *EntityData.Classname.ToString(), *outputName.ToString(), *logicOutput.TargetName.ToString(), *logicOutput.InputName.ToString());
+			continue;
+		}
+		if (useResolvedTargets)
+		{
+			eventQueue->AddEvent(this, logicOutput.TargetName, targets, logicOutput.InputName, MoveTemp(arguments), logicOutput.Delay, caller, activator);
 		}
 		else
 		{
-			// Setup a timer
-			static const FName fnFireOutputInternal("FireOutputInternal");
-			FTimerDelegate timerDelegate;
-			timerDelegate.BindUFunction(this, fnFireOutputInternal, pendingFireOutput);
-			GetWorldTimerManager().SetTimer(pendingFireOutput.TimerHandle, timerDelegate, logicOutput.Delay, false);
-			PendingOutputs.Add(pendingFireOutput.TimerHandle);
+			eventQueue->AddEvent(this, logicOutput.TargetName, logicOutput.InputName, MoveTemp(arguments), logicOutput.Delay, caller, activator);
 		}
+		++firedCount;
 	}
 
-	return result;
+	return firedCount;
 }
 
 /**
@@ -192,6 +373,9 @@ void ABaseEntity::ResetLogicOutputs()
  */
 void ABaseEntity::ResolveTargetName(const FName targetNameToResolve, TArray<ABaseEntity*>& out, ABaseEntity* caller, ABaseEntity* activator) const
 {
+	HL2_IO_SCOPE(HL2_ResolveTargetName);
+	INC_DWORD_STAT(STAT_HL2IO_TargetResolutions);
+
 	// Test for special targetnames
 	if (targetNameToResolve == tnActivator)
 	{
@@ -229,20 +413,21 @@ void ABaseEntity::ResolveTargetName(const FName targetNameToResolve, TArray<ABas
 	}
 }
 
-void ABaseEntity::FireOutputInternal(const FPendingFireOutput& data)
+void ABaseEntity::FireOutputInternal(const FName targetName, const FName inputName, const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
 {
-	// Remove timer
-	PendingOutputs.Remove(data.TimerHandle);
-
 	// Resolve targetname
 	TArray<ABaseEntity*> targets;
-	ResolveTargetName(data.Output.TargetName, targets, data.Caller, data.Activator);
+	ResolveTargetName(targetName, targets, caller, activator);
+	FireInputOnTargets(targets, inputName, args, caller);
+}
 
+void ABaseEntity::FireInputOnTargets(TArrayView<ABaseEntity* const> targets, const FName inputName, const TArray<FString>& args, ABaseEntity* caller)
+{
 	// Iterate all target entities
 	for (ABaseEntity* targetEntity : targets)
 	{
 		// Fire the input!
-		targetEntity->FireInput(data.Output.InputName, data.Args, this, data.Caller);
+		targetEntity->FireInput(inputName, args, this, caller);
 	}
 }
 
@@ -0,0 +1,111 @@
+#include "HL2RuntimePrivatePCH.h"
+
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "BaseEntity.h"
+
+BEGIN_DEFINE_SPEC(BaseEntitySpec, "HL2.BaseEntity.Spec", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+UWorld* World;
+ABaseEntity* Source;
+ABaseEntity* SpawnEntity(const TCHAR* targetName);
+void AddKillOutput(const TCHAR* targetName, const TArray<ABaseEntity*>& resolvedTargets);
+END_DEFINE_SPEC(BaseEntitySpec)
+
+ABaseEntity* BaseEntitySpec::SpawnEntity(const TCHAR* targetName)
+{
+	ABaseEntity* entity = World->SpawnActor<ABaseEntity>();
+	entity->SetTargetName(targetName);
+	return entity;
+}
+
+void BaseEntitySpec::AddKillOutput(const TCHAR* targetName, const TArray<ABaseEntity*>& resolvedTargets)
+{
+	FEntityLogicOutput& logicOutput = Source->EntityData.LogicOutputs.AddDefaulted_GetRef();
+	logicOutput.TargetName = targetName;
+	logicOutput.OutputName = TEXT("OnTrigger");
+	logicOutput.InputName = TEXT("Kill");
+	for (ABaseEntity* target : resolvedTargets)
+	{
+		logicOutput.ResolvedTargets.Add(target);
+	}
+	logicOutput.TargetsResolved = resolvedTargets.Num() > 0;
+	Source->ResetLogicOutputs();
+}
+
+void BaseEntitySpec::Define()
+{
+	Describe("ABaseEntity", [this]()
+		{
+			BeforeEach([this]()
+				{
+					World = UWorld::CreateWorld(EWorldType::Game, false);
+					FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+					worldContext.SetCurrentWorld(World);
+					World->InitializeActorsForPlay(FURL());
+					Source = SpawnEntity(TEXT("source"));
+				});
+
+			AfterEach([this]()
+				{
+					GEngine->DestroyWorldContext(World);
+					World->DestroyWorld(false);
+					World = nullptr;
+					Source = nullptr;
+				});
+
+			Describe("FireOutput", [this]()
+				{
+					It("will fire the targets resolved at import time", [this]()
+						{
+							ABaseEntity* resolvedDoor = SpawnEntity(TEXT("door"));
+							ABaseEntity* otherDoor = SpawnEntity(TEXT("door"));
+							AddKillOutput(TEXT("door"), { resolvedDoor });
+							World->GetWorldSettings()->NotifyBeginPlay();
+
+							TestEqual("FireOutput", Source->FireOutput(TEXT("OnTrigger"), {}), 1);
+							TestTrue("resolvedDoor killed", resolvedDoor->IsActorBeingDestroyed());
+							TestFalse("otherDoor killed", otherDoor->IsActorBeingDestroyed());
+						});
+
+					It("will find targets by name once an entity of that name spawns during play", [this]()
+						{
+							ABaseEntity* resolvedDoor = SpawnEntity(TEXT("door"));
+							AddKillOutput(TEXT("door"), { resolvedDoor });
+							World->GetWorldSettings()->NotifyBeginPlay();
+							ABaseEntity* lateDoor = SpawnEntity(TEXT("door"));
+
+							TestEqual("FireOutput", Source->FireOutput(TEXT("OnTrigger"), {}), 1);
+							TestTrue("resolvedDoor killed", resolvedDoor->IsActorBeingDestroyed());
+							TestTrue("lateDoor killed", lateDoor->IsActorBeingDestroyed());
+						});
+
+					It("will resolve wildcard targetnames when fired", [this]()
+						{
+							ABaseEntity* door1 = SpawnEntity(TEXT("door1"));
+							ABaseEntity* door2 = SpawnEntity(TEXT("door2"));
+							ABaseEntity* window = SpawnEntity(TEXT("window"));
+							AddKillOutput(TEXT("door*"), {});
+							World->GetWorldSettings()->NotifyBeginPlay();
+
+							Source->FireOutput(TEXT("OnTrigger"), {});
+							TestTrue("door1 killed", door1->IsActorBeingDestroyed());
+							TestTrue("door2 killed", door2->IsActorBeingDestroyed());
+							TestFalse("window killed", window->IsActorBeingDestroyed());
+						});
+
+					It("will resolve !activator when fired", [this]()
+						{
+							ABaseEntity* activator = SpawnEntity(TEXT("player"));
+							ABaseEntity* bystander = SpawnEntity(TEXT("bystander"));
+							AddKillOutput(TEXT("!activator"), {});
+							World->GetWorldSettings()->NotifyBeginPlay();
+
+							Source->FireOutput(TEXT("OnTrigger"), {}, Source, activator);
+							TestTrue("activator killed", activator->IsActorBeingDestroyed());
+							TestFalse("bystander killed", bystander->IsActorBeingDestroyed());
+						});
+				});
+		});
+}
@@ -18,6 +18,41 @@ void UBaseEntityComponent::BeginPlay()
  * Fires a logic output on the owner entity.
  * Returns the number of entities that succesfully handled the output.
  */
+void UBaseEntityComponent::OnRegister()
+{
+	Super::OnRegister();
+	ABaseEntity* entity = Cast<ABaseEntity>(GetOwner());
+	if (entity != nullptr && HandlesInputs(GetClass()))
+	{
+		entity->InputComponents.AddUnique(this);
+	}
+}
+
+void UBaseEntityComponent::OnUnregister()
+{
+	ABaseEntity* entity = Cast<ABaseEntity>(GetOwner());
+	if (entity != nullptr)
+	{
+		entity->InputComponents.Remove(this);
+	}
+	Super::OnUnregister();
+}
+
+bool UBaseEntityComponent::HandlesInputs(const UClass* componentClass)
+{
+	static TMap<TWeakObjectPtr<const UClass>, bool> handlesInputsByClass;
+	check(IsInGameThread());
+	const bool* existingResult = handlesInputsByClass.Find(componentClass);
+	if (existingResult != nullptr) { return *existingResult; }
+
+	// A native subclass may override the implementation, otherwise only a blueprint override does anything
+	const UClass* nativeClass = componentClass;
+	while (!nativeClass->HasAnyClassFlags(CLASS_Native)) { nativeClass = nativeClass->GetSuperClass(); }
+	const bool result = nativeClass != UBaseEntityComponent::StaticClass() || componentClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UBaseEntityComponent, OnInputFired));
+	handlesInputsByClass.Add(componentClass, result);
+	return result;
+}
+
 int UBaseEntityComponent::FireOutput(const FName outputName, const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator)
 {
 	return Entity->FireOutput(outputName, args, caller, activator);
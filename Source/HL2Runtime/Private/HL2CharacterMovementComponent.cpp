@@ -3,3 +3,138 @@
 
 #include "HL2CharacterMovementComponent.h"
 
+#include "EngineUtils.h"
+
+void UHL2CharacterMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	for (TActorIterator<AVBSPInfo> it(GetWorld()); it; ++it)
+	{
+		vbspInfo = *it;
+		break;
+	}
+	UpdateIgnoredBrushGeometry();
+}
+
+void UHL2CharacterMovementComponent::ComputeFloorDist(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult) const
+{
+	Super::ComputeFloorDist(CapsuleLocation, LineDistance, SweepDistance, OutFloorResult, SweepRadius, DownwardSweepResult);
+
+	const AVBSPInfo* info = GetHullTraceInfo();
+	if (info == nullptr || SweepDistance <= 0.0f) { return; }
+
+	// Use the brush floor if it's nearer than whatever physics found
+	const FVector3f extents(SweepRadius, SweepRadius, GetHullExtents().Z);
+	const FVector3f start(CapsuleLocation);
+	const FVector3f end = start - FVector3f(0.0f, 0.0f, SweepDistance);
+	const FVBSPTraceResult trace = info->TraceBox(start, end, extents, BSPContentsMask);
+	if (trace.StartSolid || trace.Brush < 0) { return; }
+	const float floorDist = trace.Fraction * SweepDistance;
+	if (OutFloorResult.bBlockingHit && OutFloorResult.FloorDist <= floorDist) { return; }
+	const FHitResult hit = MakeHitResult(trace, start, end, extents);
+	OutFloorResult.SetFromSweep(hit, floorDist, IsWalkable(hit));
+}
+
+bool UHL2CharacterMovementComponent::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
+{
+	UpdateIgnoredBrushGeometry();
+	const AVBSPInfo* info = bSweep && UpdatedComponent != nullptr ? GetHullTraceInfo() : nullptr;
+	if (info == nullptr || Delta.IsNearlyZero())
+	{
+		return Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+	}
+
+	const FVector3f extents = GetHullExtents();
+	const FVector3f start(UpdatedComponent->GetComponentLocation());
+	const FVector3f end = start + FVector3f(Delta);
+	const FVBSPTraceResult trace = info->TraceBox(start, end, extents, BSPContentsMask);
+
+	// Float error can leave the hull a hair inside a brush. A move that ends back out of every such brush is traced as usual,
+	// but one that stays inside has no hull trace to stop it, so the physics sweep collides with the brush geometry for that move instead
+	if (trace.AllSolid)
+	{
+		SetBrushGeometryIgnored(false);
+		const bool moved = Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+		SetBrushGeometryIgnored(true);
+		return moved;
+	}
+	if (trace.Brush < 0 || trace.Fraction >= 1.0f)
+	{
+		return Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+	}
+
+	// Move as far as the brushes allow, still sweeping so that other actors in the way are hit first
+	FHitResult physicsHit;
+	const bool moved = Super::MoveUpdatedComponentImpl(Delta * trace.Fraction, NewRotation, true, &physicsHit, Teleport);
+	if (OutHit != nullptr)
+	{
+		if (physicsHit.bBlockingHit)
+		{
+			// Rescale so that the time is relative to the full delta
+			*OutHit = physicsHit;
+			OutHit->Time *= trace.Fraction;
+		}
+		else
+		{
+			*OutHit = MakeHitResult(trace, start, end, extents);
+		}
+	}
+	return moved;
+}
+
+const AVBSPInfo* UHL2CharacterMovementComponent::GetHullTraceInfo() const
+{
+	if (!UseBSPHullTraces) { return nullptr; }
+	const AVBSPInfo* info = vbspInfo.Get();
+	if (info == nullptr || !info->HasBrushes()) { return nullptr; }
+	return info;
+}
+
+void UHL2CharacterMovementComponent::UpdateIgnoredBrushGeometry()
+{
+	const bool ignore = GetHullTraceInfo() != nullptr;
+	if (ignore == ignoringBrushGeometry) { return; }
+	SetBrushGeometryIgnored(ignore);
+}
+
+void UHL2CharacterMovementComponent::SetBrushGeometryIgnored(bool ignore)
+{
+	if (UpdatedPrimitive == nullptr) { return; }
+	const AVBSPInfo* info = vbspInfo.Get();
+	if (info == nullptr) { return; }
+
+	// The floor sweep picks these up too, as it uses the same ignored actors as moves
+	for (AActor* actor : info->BrushGeometry)
+	{
+		if (actor != nullptr) { UpdatedPrimitive->IgnoreActorWhenMoving(actor, ignore); }
+	}
+	ignoringBrushGeometry = ignore;
+}
+
+FVector3f UHL2CharacterMovementComponent::GetHullExtents() const
+{
+	// Source hulls are boxes, so use the box that bounds the collision shape
+	if (UpdatedPrimitive != nullptr)
+	{
+		return FVector3f(UpdatedPrimitive->GetCollisionShape().GetExtent());
+	}
+	return FVector3f(UpdatedComponent->Bounds.BoxExtent);
+}
+
+FHitResult UHL2CharacterMovementComponent::MakeHitResult(const FVBSPTraceResult& trace, const FVector3f& start, const FVector3f& end, const FVector3f& extents)
+{
+	FHitResult hit(trace.Fraction);
+	hit.bBlockingHit = true;
+	hit.TraceStart = FVector(start);
+	hit.TraceEnd = FVector(end);
+	hit.Location = FVector(trace.EndPos);
+	hit.Distance = (trace.EndPos - start).Size();
+	hit.Normal = FVector(trace.Normal);
+	hit.ImpactNormal = hit.Normal;
+
+	// The box touches the plane at its face along the normal
+	const float offset = FMath::Abs(trace.Normal.X) * extents.X + FMath::Abs(trace.Normal.Y) * extents.Y + FMath::Abs(trace.Normal.Z) * extents.Z;
+	hit.ImpactPoint = FVector(trace.EndPos - trace.Normal * offset);
+	hit.Item = trace.Brush;
+	return hit;
+}
@@ -1,5 +1,112 @@
 #include "HL2EntityData.h"
 
+/** Parses up to maxCount space separated floats in place, returning how many were found. */
+static int ParseFloats(const FString& value, float* out, int maxCount)
+{
+	const TCHAR* cur = *value;
+	int count = 0;
+	while (count < maxCount)
+	{
+		while (*cur == TEXT(' ')) { ++cur; }
+		if (*cur == TEXT('\0')) { break; }
+		out[count++] = FCString::Atof(cur);
+		while (*cur != TEXT(' ') && *cur != TEXT('\0')) { ++cur; }
+	}
+	return count;
+}
+
+static bool ParseInt(const FString& value, int32& out)
+{
+	out = FCString::Atoi(*value);
+	return true;
+}
+
+static bool ParseBool(const FString& value, bool& out)
+{
+	out = value.ToBool();
+	return true;
+}
+
+static bool ParseFloat(const FString& value, float& out)
+{
+	out = FCString::Atof(*value);
+	return true;
+}
+
+static bool ParseVector(const FString& value, FVector3f& out)
+{
+	float components[3];
+	if (ParseFloats(value, components, 3) < 3) { return false; }
+	out = FVector3f(components[0], components[1], components[2]);
+	return true;
+}
+
+static bool ParseVector4(const FString& value, FVector4f& out)
+{
+	float components[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	if (ParseFloats(value, components, 4) < 3) { return false; }
+	out = FVector4f(components[0], components[1], components[2], components[3]);
+	return true;
+}
+
+template<typename T>
+bool FHL2EntityData::TryGetTyped(FName key, T& out, bool (*parse)(const FString&, T&)) const
+{
+	FHL2EntityTypedValue* typedValue = TypedValues.Find(key);
+	if (typedValue != nullptr && typedValue->IsType<T>())
+	{
+		out = typedValue->Get<T>();
+		return true;
+	}
+	const FString* value = KeyValues.Find(key);
+	if (value == nullptr) { return false; }
+	T parsed;
+	if (!parse(*value, parsed)) { return false; }
+
+	// A key read as several types keeps only the most recent one
+	if (typedValue != nullptr)
+	{
+		typedValue->Set<T>(parsed);
+	}
+	else
+	{
+		TypedValues.Add(key, FHL2EntityTypedValue(TInPlaceType<T>(), parsed));
+	}
+	out = parsed;
+	return true;
+}
+
+void FHL2EntityData::CacheCommonTypedValues() const
+{
+	const static FName fnOrigin(TEXT("origin"));
+	const static FName fnAngles(TEXT("angles"));
+	const static FName fnSpawnflags(TEXT("spawnflags"));
+	const static FName fnRendercolor(TEXT("rendercolor"));
+	const static FName fnRenderamt(TEXT("renderamt"));
+	const static FName fnLight(TEXT("_light"));
+	const static FName fnAmbient(TEXT("_ambient"));
+	FVector3f vector;
+	FVector4f vector4;
+	int32 integer;
+	TryGetVector(fnOrigin, vector);
+	TryGetVector(fnAngles, vector);
+	TryGetVector(fnRendercolor, vector);
+	TryGetInt(fnSpawnflags, integer);
+	TryGetInt(fnRenderamt, integer);
+	TryGetVector4(fnLight, vector4);
+	TryGetVector4(fnAmbient, vector4);
+}
+
+void FHL2EntityData::ResetTypedValues()
+{
+	TypedValues.Empty();
+}
+
+void FHL2EntityData::ResetTypedValue(FName key)
+{
+	TypedValues.Remove(key);
+}
+
 FString FHL2EntityData::GetString(FName key) const
 {
 	FString tmp;
@@ -24,10 +131,7 @@ int FHL2EntityData::GetInt(FName key) const
 
 bool FHL2EntityData::TryGetInt(FName key, int& out) const
 {
-	FString value;
-	if (!TryGetString(key, value)) { return false; }
-	out = FCString::Atoi(*value);
-	return true;
+	return TryGetTyped<int32>(key, out, &ParseInt);
 }
 
 bool FHL2EntityData::GetBool(FName key) const
@@ -39,10 +143,7 @@ bool FHL2EntityData::GetBool(FName key) const
 
 bool FHL2EntityData::TryGetBool(FName key, bool& out) const
 {
-	FString value;
-	if (!TryGetString(key, value)) { return false; }
-	out = value.ToBool();
-	return true;
+	return TryGetTyped<bool>(key, out, &ParseBool);
 }
 
 float FHL2EntityData::GetFloat(FName key) const
@@ -54,10 +155,7 @@ float FHL2EntityData::GetFloat(FName key) const
 
 bool FHL2EntityData::TryGetFloat(FName key, float& out) const
 {
-	FString value;
-	if (!TryGetString(key, value)) { return false; }
-	out = FCString::Atof(*value);
-	return true;
+	return TryGetTyped<float>(key, out, &ParseFloat);
 }
 
 FVector3f FHL2EntityData::GetVector(FName key) const
@@ -69,14 +167,7 @@ FVector3f FHL2EntityData::GetVector(FName key) const
 
 bool FHL2EntityData::TryGetVector(FName key, FVector3f& out) const
 {
-	FString value;
-	if (!TryGetString(key, value)) { return false; }
-	TArray<FString> segments;
-	if (value.ParseIntoArray(segments, TEXT(" "), true) < 3) { return false; }
-	out.X = FCString::Atof(*segments[0]);
-	out.Y = FCString::Atof(*segments[1]);
-	out.Z = FCString::Atof(*segments[2]);
-	return true;
+	return TryGetTyped<FVector3f>(key, out, &ParseVector);
 }
 
 FVector4f FHL2EntityData::GetVector4(FName key) const
@@ -88,13 +179,5 @@ FVector4f FHL2EntityData::GetVector4(FName key) const
 
 bool FHL2EntityData::TryGetVector4(FName key, FVector4f& out) const
 {
-	FString value;
-	if (!TryGetString(key, value)) { return false; }
-	TArray<FString> segments;
-	if (value.ParseIntoArray(segments, TEXT(" "), true) < 3) { return false; }
-	out.X = FCString::Atof(*segments[0]);
-	out.Y = FCString::Atof(*segments[1]);
-	out.Z = FCString::Atof(*segments[2]);
-	out.W = FCString::Atof(*segments[3]);
-	return true;
+	return TryGetTyped<FVector4f>(key, out, &ParseVector4);
 }
\ No newline at end of file
@@ -52,7 +52,7 @@ bool UHL2EntityDataUtils::TryGetRotator(const FHL2EntityData& entityData, FName
 {
 	FVector3f value;
 	if (!entityData.TryGetVector(key, value)) { return false; }
-	out = FRotator(SourceToUnreal.Rotator(FRotator3f::MakeFromEuler(FVector3f(value.Z, -value.X, 180.0f - value.Y))));
+	out = ConvertSourceAnglesToUnreal(FVector(value));
 	return true;
 }
 
@@ -94,6 +94,11 @@ FQuat UHL2EntityDataUtils::ConvertSourceRotationToUnreal(const FQuat& rotation)
 	return FQuat(SourceToUnreal.Quat(FQuat4f(rotation)));
 }
 
+FRotator UHL2EntityDataUtils::ConvertSourceAnglesToUnreal(const FVector& angles)
+{
+	return FRotator(SourceToUnreal.Rotator(FRotator3f::MakeFromEuler(FVector3f(angles.Z, -angles.X, 180.0f - angles.Y))));
+}
+
 FTransform UHL2EntityDataUtils::ConvertSourceTransformToUnreal(const FTransform& transform)
 {
 	return FTransform(SourceToUnreal.Transform(FTransform3f(transform)));
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HL2EntitySubsystem.h"
+
+#include "BaseEntity.h"
+
+void UHL2EntitySubsystem::Initialize(FSubsystemCollectionBase& collection)
+{
+	Super::Initialize(collection);
+	targetNameTrie.AddDefaulted();
+}
+
+void UHL2EntitySubsystem::Deinitialize()
+{
+	entitiesByTargetName.Empty();
+	entitiesByClassname.Empty();
+	indexedEntities.Empty();
+	targetNameTrie.Empty();
+	namesRegisteredDuringPlay.Empty();
+	Super::Deinitialize();
+}
+
+void UHL2EntitySubsystem::RegisterEntity(ABaseEntity* entity)
+{
+	const FIndexedNames* indexedNames = indexedEntities.Find(entity);
+	if (indexedNames != nullptr)
+	{
+		if (indexedNames->TargetName == entity->TargetName && indexedNames->Classname == entity->EntityData.Classname) { return; }
+		UnregisterEntity(entity);
+	}
+
+	FIndexedNames& newIndexedNames = indexedEntities.Add(entity);
+	newIndexedNames.TargetName = entity->TargetName;
+	newIndexedNames.Classname = entity->EntityData.Classname;
+	if (!entity->TargetName.IsNone())
+	{
+		entitiesByTargetName.FindOrAdd(entity->TargetName).Add(entity);
+		targetNameTrie[FindOrAddTrieNode(entity->TargetName.ToString())].Entities.Add(entity);
+	}
+	if (!entity->EntityData.Classname.IsNone())
+	{
+		entitiesByClassname.FindOrAdd(entity->EntityData.Classname).Add(entity);
+	}
+	if (GetWorld()->HasBegunPlay())
+	{
+		if (!entity->TargetName.IsNone()) { namesRegisteredDuringPlay.Add(entity->TargetName); }
+		if (!entity->EntityData.Classname.IsNone()) { namesRegisteredDuringPlay.Add(entity->EntityData.Classname); }
+	}
+}
+
+void UHL2EntitySubsystem::UnregisterEntity(ABaseEntity* entity)
+{
+	FIndexedNames indexedNames;
+	if (!indexedEntities.RemoveAndCopyValue(entity, indexedNames)) { return; }
+	if (!indexedNames.TargetName.IsNone())
+	{
+		TArray<ABaseEntity*>* entities = entitiesByTargetName.Find(indexedNames.TargetName);
+		if (entities != nullptr)
+		{
+			entities->RemoveSingleSwap(entity);
+			if (entities->Num() == 0) { entitiesByTargetName.Remove(indexedNames.TargetName); }
+		}
+
+		// Empty trie nodes are kept, the set of names seen in a world is bounded
+		const int32 nodeIndex = FindTrieNode(indexedNames.TargetName.ToString());
+		if (nodeIndex != INDEX_NONE)
+		{
+			targetNameTrie[nodeIndex].Entities.RemoveSingleSwap(entity);
+		}
+	}
+	if (!indexedNames.Classname.IsNone())
+	{
+		TArray<ABaseEntity*>* entities = entitiesByClassname.Find(indexedNames.Classname);
+		if (entities != nullptr)
+		{
+			entities->RemoveSingleSwap(entity);
+			if (entities->Num() == 0) { entitiesByClassname.Remove(indexedNames.Classname); }
+		}
+	}
+}
+
+void UHL2EntitySubsystem::FindEntitiesByTargetName(const FName targetName, TArray<ABaseEntity*>& outEntities) const
+{
+	// Exact targetname matches
+	const TArray<ABaseEntity*>* entities = entitiesByTargetName.Find(targetName);
+	if (entities != nullptr)
+	{
+		outEntities.Append(*entities);
+	}
+
+	// Classname matches, skipping entities already found by their targetname
+	entities = entitiesByClassname.Find(targetName);
+	if (entities != nullptr)
+	{
+		for (ABaseEntity* entity : *entities)
+		{
+			if (entity->TargetName != targetName) { outEntities.Add(entity); }
+		}
+	}
+
+	// Wildcard matches, the node of the prefix itself is excluded as a match must be longer than the prefix
+	// The name is built on the stack and walked straight down the trie, so nothing is kept per queried name
+	const FNameBuilder targetNameStr(targetName);
+	const FStringView targetNameView = targetNameStr.ToView();
+	if (!targetNameView.EndsWith(TEXT('*'))) { return; }
+	const int32 nodeIndex = FindTrieNode(targetNameView.LeftChop(1));
+	if (nodeIndex == INDEX_NONE) { return; }
+	for (const TPair<TCHAR, int32>& child : targetNameTrie[nodeIndex].Children)
+	{
+		CollectTrieEntities(child.Value, outEntities);
+	}
+}
+
+bool UHL2EntitySubsystem::HasEntitiesRegisteredDuringPlay(const FName name) const
+{
+	return namesRegisteredDuringPlay.Num() > 0 && namesRegisteredDuringPlay.Contains(name);
+}
+
+int32 UHL2EntitySubsystem::FindTrieNode(FStringView prefix) const
+{
+	int32 nodeIndex = 0;
+	for (const TCHAR ch : prefix)
+	{
+		const int32* childIndex = targetNameTrie[nodeIndex].Children.Find(FChar::ToLower(ch));
+		if (childIndex == nullptr) { return INDEX_NONE; }
+		nodeIndex = *childIndex;
+	}
+	return nodeIndex;
+}
+
+int32 UHL2EntitySubsystem::FindOrAddTrieNode(const FString& prefix)
+{
+	int32 nodeIndex = 0;
+	for (const TCHAR ch : prefix)
+	{
+		const TCHAR key = FChar::ToLower(ch);
+		const int32* childIndex = targetNameTrie[nodeIndex].Children.Find(key);
+		if (childIndex != nullptr)
+		{
+			nodeIndex = *childIndex;
+			continue;
+		}
+		const int32 newIndex = targetNameTrie.AddDefaulted();
+		targetNameTrie[nodeIndex].Children.Add(key, newIndex);
+		nodeIndex = newIndex;
+	}
+	return nodeIndex;
+}
+
+void UHL2EntitySubsystem::CollectTrieEntities(int32 nodeIndex, TArray<ABaseEntity*>& outEntities) const
+{
+	const FTargetNameTrieNode& node = targetNameTrie[nodeIndex];
+	outEntities.Append(node.Entities);
+	for (const TPair<TCHAR, int32>& child : node.Children)
+	{
+		CollectTrieEntities(child.Value, outEntities);
+	}
+}
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HL2EventQueueSubsystem.h"
+
+#include "BaseEntity.h"
+#include "Engine/World.h"
+#include "HL2IOTelemetry.h"
+
+void UHL2EventQueueSubsystem::Tick(float deltaTime)
+{
+	Super::Tick(deltaTime);
+	HL2_IO_SCOPE(HL2_ServiceEventQueue);
+	SCOPE_CYCLE_COUNTER(STAT_HL2IO_ServiceEvents);
+
+	// Events queued while servicing have a positive delay, so they always land after the current time
+	const double now = GetWorld()->GetTimeSeconds();
+	FQueuedEvent event;
+	while (events.Num() > 0 && events.HeapTop().FireTime <= now)
+	{
+		events.HeapPop(event, FQueuedEventOrder(), false);
+
+		// Timers never fired for destroyed entities, neither do queued events
+		ABaseEntity* source = event.Source.Get();
+		if (source == nullptr) { continue; }
+		if (event.TargetsResolved)
+		{
+			TArray<ABaseEntity*, TInlineAllocator<4>> targets;
+			for (const TWeakObjectPtr<ABaseEntity>& target : event.Targets)
+			{
+				if (target.IsValid()) { targets.Add(target.Get()); }
+			}
+			source->FireInputOnTargets(targets, event.InputName, event.Args, event.Caller.Get());
+		}
+		else
+		{
+			source->FireOutputInternal(event.TargetName, event.InputName, event.Args, event.Caller.Get(), event.Activator.Get());
+		}
+	}
+	SET_DWORD_STAT(STAT_HL2IO_EventsPending, events.Num());
+}
+
+TStatId UHL2EventQueueSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHL2EventQueueSubsystem, STATGROUP_Tickables);
+}
+
+void UHL2EventQueueSubsystem::AddEvent(ABaseEntity* source, const FName targetName, const FName inputName, TArray<FString>&& args, float delay, ABaseEntity* caller, ABaseEntity* activator)
+{
+	FQueuedEvent event;
+	event.FireTime = GetWorld()->GetTimeSeconds() + delay;
+	event.Serial = nextSerial++;
+	event.Source = source;
+	event.TargetName = targetName;
+	event.InputName = inputName;
+	event.Args = MoveTemp(args);
+	event.Caller = caller;
+	event.Activator = activator;
+	INC_DWORD_STAT(STAT_HL2IO_EventsQueued);
+	HL2_IO_RECORD(Queued, source, inputName, caller);
+	events.HeapPush(MoveTemp(event), FQueuedEventOrder());
+}
+
+void UHL2EventQueueSubsystem::AddEvent(ABaseEntity* source, const FName targetName, TArrayView<ABaseEntity* const> targets, const FName inputName, TArray<FString>&& args, float delay, ABaseEntity* caller, ABaseEntity* activator)
+{
+	FQueuedEvent event;
+	event.FireTime = GetWorld()->GetTimeSeconds() + delay;
+	event.Serial = nextSerial++;
+	event.Source = source;
+	event.TargetName = targetName;
+	event.Targets.Reserve(targets.Num());
+	for (ABaseEntity* target : targets)
+	{
+		event.Targets.Add(target);
+	}
+	event.TargetsResolved = true;
+	event.InputName = inputName;
+	event.Args = MoveTemp(args);
+	event.Caller = caller;
+	event.Activator = activator;
+	INC_DWORD_STAT(STAT_HL2IO_EventsQueued);
+	HL2_IO_RECORD(Queued, source, inputName, caller);
+	events.HeapPush(MoveTemp(event), FQueuedEventOrder());
+}
+
+int UHL2EventQueueSubsystem::CancelEvents(const ABaseEntity* source)
+{
+	const int numEvents = events.Num();
+	events.RemoveAll([source](const FQueuedEvent& event) { return event.Source.Get() == source; });
+	if (events.Num() == numEvents) { return 0; }
+	HL2_IO_RECORD(Cancelled, source, NAME_None, nullptr);
+	events.Heapify(FQueuedEventOrder());
+	return numEvents - events.Num();
+}
+
+int UHL2EventQueueSubsystem::CancelEventsOn(const ABaseEntity* target, const FName inputName)
+{
+	if (target->TargetName.IsNone()) { return 0; }
+	const int numEvents = events.Num();
+	events.RemoveAll([target, inputName](const FQueuedEvent& event)
+	{
+		return event.TargetName == target->TargetName && (inputName.IsNone() || event.InputName == inputName);
+	});
+	if (events.Num() == numEvents) { return 0; }
+	HL2_IO_RECORD(Cancelled, target, inputName, nullptr);
+	events.Heapify(FQueuedEventOrder());
+	return numEvents - events.Num();
+}
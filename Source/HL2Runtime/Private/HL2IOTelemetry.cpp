@@ -0,0 +1,93 @@
+#include "HL2IOTelemetry.h"
+
+#include "BaseEntity.h"
+#include "Misc/OutputDeviceRedirector.h"
+
+DEFINE_STAT(STAT_HL2IO_OutputsFired);
+DEFINE_STAT(STAT_HL2IO_InputsFired);
+DEFINE_STAT(STAT_HL2IO_TargetResolutions);
+DEFINE_STAT(STAT_HL2IO_EventsQueued);
+DEFINE_STAT(STAT_HL2IO_EventsPending);
+DEFINE_STAT(STAT_HL2IO_ServiceEvents);
+
+#if HL2_IO_TELEMETRY
+
+TAutoConsoleVariable<bool> CVarHL2IOTrace(TEXT("hl2.IOTrace"), false, TEXT("Logs every entity input and output as it fires."));
+TAutoConsoleVariable<bool> CVarHL2IORecord(TEXT("hl2.IORecord"), false, TEXT("Records entity IO into a ring buffer that can be dumped with hl2.DumpIOTimeline."));
+static TAutoConsoleVariable<int32> CVarHL2IORecordCapacity(TEXT("hl2.IORecordCapacity"), 4096, TEXT("The number of IO events kept by hl2.IORecord. Changing it clears the recording."));
+
+static const TCHAR* GetRecordKindName(EHL2IORecordKind kind)
+{
+	switch (kind)
+	{
+		case EHL2IORecordKind::Output: return TEXT("output");
+		case EHL2IORecordKind::Input: return TEXT("input");
+		case EHL2IORecordKind::Queued: return TEXT("queued");
+		case EHL2IORecordKind::Cancelled: return TEXT("cancelled");
+	}
+	return TEXT("unknown");
+}
+
+FHL2IORecorder& FHL2IORecorder::Get()
+{
+	static FHL2IORecorder recorder;
+	return recorder;
+}
+
+void FHL2IORecorder::Record(EHL2IORecordKind kind, const ABaseEntity* entity, const FName name, const ABaseEntity* other)
+{
+	const int32 newCapacity = FMath::Max(1, CVarHL2IORecordCapacity.GetValueOnGameThread());
+	if (newCapacity != capacity)
+	{
+		capacity = newCapacity;
+		records.Empty(capacity);
+		nextRecord = 0;
+	}
+
+	FHL2IORecord record;
+	record.Time = FPlatformTime::Seconds();
+	record.Kind = kind;
+	record.EntityName = GetRecordName(entity);
+	record.Name = name;
+	record.OtherName = GetRecordName(other);
+	if (records.Num() < capacity)
+	{
+		records.Add(record);
+	}
+	else
+	{
+		records[nextRecord] = record;
+	}
+	nextRecord = (nextRecord + 1) % capacity;
+}
+
+void FHL2IORecorder::DumpTimeline(const FName entityName, FOutputDevice& ar) const
+{
+	if (records.Num() == 0) { return; }
+
+	// Until the buffer wraps, the oldest record is the first
+	const int32 first = records.Num() < capacity ? 0 : nextRecord;
+	const double startTime = records[first].Time;
+	for (int32 i = 0; i < records.Num(); ++i)
+	{
+		const FHL2IORecord& record = records[(first + i) % records.Num()];
+		if (!entityName.IsNone() && record.EntityName != entityName && record.OtherName != entityName) { continue; }
+		ar.Logf(TEXT("%10.4f %s %s '%s' from %s"), record.Time - startTime, *record.EntityName.ToString(), GetRecordKindName(record.Kind), *record.Name.ToString(), *record.OtherName.ToString());
+	}
+}
+
+FName FHL2IORecorder::GetRecordName(const ABaseEntity* entity)
+{
+	if (entity == nullptr) { return NAME_None; }
+	return entity->TargetName.IsNone() ? entity->EntityData.Classname : entity->TargetName;
+}
+
+static FAutoConsoleCommand GDumpIOTimelineCommand(
+	TEXT("hl2.DumpIOTimeline"),
+	TEXT("Logs the recorded IO timeline of the entity with the given targetname or classname, or of every entity if none is given. Requires hl2.IORecord."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& args)
+	{
+		FHL2IORecorder::Get().DumpTimeline(args.Num() > 0 ? FName(*args[0]) : NAME_None, *GLog);
+	}));
+
+#endif
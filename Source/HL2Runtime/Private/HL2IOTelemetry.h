@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+class ABaseEntity;
+
+// Entity IO telemetry: stats, insights events, the trace log and the timeline recorder. None of it is compiled into shipping builds.
+#define HL2_IO_TELEMETRY !UE_BUILD_SHIPPING
+
+DECLARE_STATS_GROUP(TEXT("HL2 IO"), STATGROUP_HL2IO, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Outputs Fired"), STAT_HL2IO_OutputsFired, STATGROUP_HL2IO, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Inputs Fired"), STAT_HL2IO_InputsFired, STATGROUP_HL2IO, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Target Resolutions"), STAT_HL2IO_TargetResolutions, STATGROUP_HL2IO, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Events Queued"), STAT_HL2IO_EventsQueued, STATGROUP_HL2IO, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Events Pending"), STAT_HL2IO_EventsPending, STATGROUP_HL2IO, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Service Event Queue"), STAT_HL2IO_ServiceEvents, STATGROUP_HL2IO, );
+
+#if HL2_IO_TELEMETRY
+
+enum class EHL2IORecordKind : uint8
+{
+	Output,
+	Input,
+	Queued,
+	Cancelled
+};
+
+/** One entry of the IO timeline. */
+struct FHL2IORecord
+{
+	double Time = 0.0;
+	EHL2IORecordKind Kind = EHL2IORecordKind::Output;
+	FName EntityName;
+	FName Name;
+	FName OtherName;
+};
+
+/**
+ * Records entity IO into a fixed size ring buffer while hl2.IORecord is set, so the recent timeline of an entity can be dumped with hl2.DumpIOTimeline.
+ */
+class FHL2IORecorder
+{
+private:
+
+	TArray<FHL2IORecord> records;
+	int32 capacity = 0;
+	int32 nextRecord = 0;
+
+public:
+
+	static FHL2IORecorder& Get();
+
+	/** Records an IO event on the entity. Other is the caller of inputs and outputs, if any. */
+	void Record(EHL2IORecordKind kind, const ABaseEntity* entity, const FName name, const ABaseEntity* other);
+
+	/** Writes all recorded events involving the entity name, or every event if the name is none, oldest first. */
+	void DumpTimeline(const FName entityName, FOutputDevice& ar) const;
+
+	/** Gets the name an entity is recorded under, its targetname or else its classname. */
+	static FName GetRecordName(const ABaseEntity* entity);
+
+};
+
+extern TAutoConsoleVariable<bool> CVarHL2IOTrace;
+extern TAutoConsoleVariable<bool> CVarHL2IORecord;
+
+#define HL2_IO_SCOPE(name) TRACE_CPUPROFILER_EVENT_SCOPE(name)
+#define HL2_IO_RECORD(kind, entity, name, other) do { if (CVarHL2IORecord.GetValueOnGameThread()) { FHL2IORecorder::Get().Record(EHL2IORecordKind::kind, entity, name, other); } } while (0)
+#define HL2_IO_TRACE(format, ...) do { if (CVarHL2IOTrace.GetValueOnGameThread()) { UE_LOG(LogHL2IOSystem, Log, format, ##__VA_ARGS__); } } while (0)
+
+#else
+
+#define HL2_IO_SCOPE(name)
+#define HL2_IO_RECORD(kind, entity, name, other) do { } while (0)
+#define HL2_IO_TRACE(format, ...) do { } while (0)
+
+#endif
@@ -3,11 +3,61 @@
 #include "Engine/StaticMesh.h"
 #include "Engine/SkeletalMesh.h"
 
+void UHL2ModelData::GetStaticMeshBodygroups(const UStaticMesh* staticMesh, TArray<int>& outCombination) const
+{
+	for (const FModelBodygroupVariant& variant : BakedVariants)
+	{
+		if (variant.Mesh == staticMesh)
+		{
+			outCombination = variant.Combination;
+			return;
+		}
+	}
+	outCombination.Init(0, BodygroupOrder.Num());
+}
+
+UStaticMesh* UHL2ModelData::FindBakedVariant(TArrayView<const int> combination) const
+{
+	for (const FModelBodygroupVariant& variant : BakedVariants)
+	{
+		if (variant.Combination == combination) { return variant.Mesh; }
+	}
+	return nullptr;
+}
+
+UStaticMesh* UHL2ModelData::GetDefaultBakedVariant(UStaticMesh* staticMesh) const
+{
+	if (BakedVariants.Num() == 0) { return staticMesh; }
+	for (const FModelBodygroupVariant& variant : BakedVariants)
+	{
+		if (variant.Mesh == staticMesh) { return staticMesh; }
+	}
+	TArray<int> combination;
+	combination.Init(0, BodygroupOrder.Num());
+	UStaticMesh* variant = FindBakedVariant(combination);
+	return variant != nullptr ? variant : staticMesh;
+}
+
 bool UHL2ModelData::ApplyBodygroupToStaticMesh(UStaticMeshComponent* target, const FName bodygroupName, int index)
 {
 	const FModelBodygroup* bodygroup = Bodygroups.Find(bodygroupName);
 	if (bodygroup == nullptr) { return false; }
 	if (!bodygroup->Mappings.IsValidIndex(index)) { return false; }
+
+	// Swap to the mesh baked for the new combination
+	if (BakedVariants.Num() > 0)
+	{
+		const int orderIndex = BodygroupOrder.IndexOfByKey(bodygroupName);
+		if (orderIndex == INDEX_NONE) { return false; }
+		TArray<int> combination;
+		GetStaticMeshBodygroups(target->GetStaticMesh(), combination);
+		combination[orderIndex] = index;
+		UStaticMesh* variant = FindBakedVariant(combination);
+		if (variant == nullptr) { return false; }
+		if (variant != target->GetStaticMesh()) { target->SetStaticMesh(variant); }
+		return true;
+	}
+
 	const FModelBodygroupMapping& mapping = bodygroup->Mappings[index];
 	const int lodCount = target->GetStaticMesh()->GetNumLODs();
 	for (const int sectionIndex : bodygroup->AllSections)
@@ -0,0 +1,265 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HL2PVSTickSubsystem.h"
+
+#include "BaseEntity.h"
+#include "VBSPInfo.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("HL2 PVS Tick Update"), STAT_HL2PVSTickUpdate, STATGROUP_Game);
+
+static TAutoConsoleVariable<bool> CVarHL2PVSTickThrottle(TEXT("hl2.PVSTickThrottle"), true, TEXT("Throttles the ticks of entities outside the pvs of every local player."));
+static TAutoConsoleVariable<float> CVarHL2PVSThrottleInterval(TEXT("hl2.PVSThrottleInterval"), 0.5f, TEXT("The tick interval, in seconds, of throttled entities outside the pvs."));
+static TAutoConsoleVariable<float> CVarHL2PVSDormancyDelay(TEXT("hl2.PVSDormancyDelay"), 1.0f, TEXT("How long, in seconds, an entity must be outside the pvs before it is throttled."));
+
+void UHL2PVSTickSubsystem::Deinitialize()
+{
+	WakeAll();
+	entities.Empty();
+	entityBounds.Empty();
+	entityClusters.Empty();
+	entityLastVisibleTimes.Empty();
+	entityThrottleSlots.Empty();
+	entityIndices.Empty();
+	throttleSlots.Empty();
+	freeThrottleSlots.Empty();
+	Super::Deinitialize();
+}
+
+void UHL2PVSTickSubsystem::Tick(float deltaTime)
+{
+	Super::Tick(deltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_HL2PVSTickUpdate);
+
+	const AVBSPInfo* info = vbspInfo.Get();
+	if (!CVarHL2PVSTickThrottle.GetValueOnGameThread() || info == nullptr || !GatherVisibleClusters(*info))
+	{
+		WakeAll();
+		return;
+	}
+
+	// Entities without bounds have nowhere to be, and entities outside every cluster may be in the void
+	// Treat both as visible rather than risk stalling them
+	const double now = GetWorld()->GetTimeSeconds();
+	const double dormancyDelay = CVarHL2PVSDormancyDelay.GetValueOnGameThread();
+	for (int32 i = 0; i < entities.Num(); ++i)
+	{
+		// The policy may have changed since the entity was throttled, in which case it is woken and throttled again under the new one
+		const EHL2PVSTickPolicy policy = GetTickPolicy(entities[i]);
+		if (entityThrottleSlots[i] != INDEX_NONE && throttleSlots[entityThrottleSlots[i]].Policy != policy) { Wake(i); }
+		if (policy == EHL2PVSTickPolicy::AlwaysTick)
+		{
+			// Count as visible, so that switching back waits out the dormancy delay
+			entityLastVisibleTimes[i] = now;
+			continue;
+		}
+
+		// Only walk the tree again once the entity has moved
+		const FBox bounds = GetEntityBounds(entities[i]);
+		if (bounds != entityBounds[i])
+		{
+			entityBounds[i] = bounds;
+			if (bounds.IsValid)
+			{
+				info->FindClustersInBox(FBox3f(bounds), entityClusters[i]);
+			}
+			else
+			{
+				entityClusters[i].Reset();
+			}
+		}
+		bool visible = entityClusters[i].Num() == 0;
+		for (const int32 cluster : entityClusters[i])
+		{
+			if (!visibleClusters.IsValidIndex(cluster) || visibleClusters[cluster])
+			{
+				visible = true;
+				break;
+			}
+		}
+		if (visible)
+		{
+			entityLastVisibleTimes[i] = now;
+			if (entityThrottleSlots[i] != INDEX_NONE) { Wake(i); }
+			continue;
+		}
+		if (entityThrottleSlots[i] == INDEX_NONE && now - entityLastVisibleTimes[i] >= dormancyDelay)
+		{
+			Throttle(i, policy);
+		}
+	}
+}
+
+TStatId UHL2PVSTickSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHL2PVSTickSubsystem, STATGROUP_Tickables);
+}
+
+void UHL2PVSTickSubsystem::RegisterEntity(ABaseEntity* entity)
+{
+	if (entityIndices.Contains(entity)) { return; }
+	if (!vbspInfo.IsValid() && entity->VBSPInfo != nullptr)
+	{
+		vbspInfo = entity->VBSPInfo;
+	}
+	entityIndices.Add(entity, entities.Add(entity));
+	entityBounds.Add(FBox(ForceInit));
+	entityClusters.AddDefaulted();
+	entityLastVisibleTimes.Add(GetWorld()->GetTimeSeconds());
+	entityThrottleSlots.Add(INDEX_NONE);
+}
+
+void UHL2PVSTickSubsystem::UnregisterEntity(ABaseEntity* entity)
+{
+	int32 index;
+	if (!entityIndices.RemoveAndCopyValue(entity, index)) { return; }
+	if (entityThrottleSlots[index] != INDEX_NONE) { Wake(index); }
+	entities.RemoveAtSwap(index, 1, false);
+	entityBounds.RemoveAtSwap(index, 1, false);
+	entityClusters.RemoveAtSwap(index, 1, false);
+	entityLastVisibleTimes.RemoveAtSwap(index, 1, false);
+	entityThrottleSlots.RemoveAtSwap(index, 1, false);
+	if (index < entities.Num())
+	{
+		entityIndices[entities[index]] = index;
+	}
+}
+
+EHL2PVSTickPolicy UHL2PVSTickSubsystem::GetTickPolicy(const ABaseEntity* entity)
+{
+	return entity->PVSTickPolicy;
+}
+
+FBox UHL2PVSTickSubsystem::GetEntityBounds(const ABaseEntity* entity)
+{
+	const FBox bounds = entity->GetComponentsBoundingBox(true);
+	if (bounds.IsValid) { return bounds; }
+
+	// Point entities have no primitives, so fall back to where they are
+	const USceneComponent* rootComponent = entity->GetRootComponent();
+	if (rootComponent == nullptr) { return FBox(ForceInit); }
+	const FVector location = rootComponent->GetComponentLocation();
+	return FBox(location, location);
+}
+
+bool UHL2PVSTickSubsystem::GatherVisibleClusters(const AVBSPInfo& info)
+{
+	if (visibleClusters.Num() != info.Clusters.Num())
+	{
+		visibleClusters.Init(false, info.Clusters.Num());
+	}
+	else if (visibleClusters.Num() > 0)
+	{
+		visibleClusters.SetRange(0, visibleClusters.Num(), false);
+	}
+
+	// Without any local player, for example on a dedicated server, there is no pvs to throttle against
+	bool anyLocalPlayer = false;
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	{
+		const APlayerController* playerController = it->Get();
+		if (playerController == nullptr || !playerController->IsLocalController()) { continue; }
+		FVector viewLocation;
+		FRotator viewRotation;
+		playerController->GetPlayerViewPoint(viewLocation, viewRotation);
+		const int32 cluster = info.FindCluster(FVector3f(viewLocation));
+		if (!visibleClusters.IsValidIndex(cluster)) { return false; }
+		anyLocalPlayer = true;
+		visibleClusters[cluster] = true;
+		for (const int32 otherCluster : info.GetClusterVisibility(cluster))
+		{
+			if (visibleClusters.IsValidIndex(otherCluster)) { visibleClusters[otherCluster] = true; }
+		}
+	}
+	return anyLocalPlayer;
+}
+
+void UHL2PVSTickSubsystem::Throttle(int32 index, EHL2PVSTickPolicy policy)
+{
+	if (policy == EHL2PVSTickPolicy::AlwaysTick) { return; }
+	ABaseEntity* entity = entities[index];
+	const int32 slot = freeThrottleSlots.Num() > 0 ? freeThrottleSlots.Pop(false) : throttleSlots.AddDefaulted();
+	FSavedEntityTick& saved = throttleSlots[slot];
+	saved.Policy = policy;
+	entityThrottleSlots[index] = slot;
+	++numThrottled;
+
+	const bool dormant = policy == EHL2PVSTickPolicy::Dormant;
+	const float throttleInterval = CVarHL2PVSThrottleInterval.GetValueOnGameThread();
+	if (entity->PrimaryActorTick.bCanEverTick)
+	{
+		ThrottleTick(entity->PrimaryActorTick, saved.Tick, dormant, throttleInterval);
+	}
+	for (UActorComponent* component : entity->GetComponents())
+	{
+		if (component == nullptr || !component->PrimaryComponentTick.bCanEverTick) { continue; }
+		FSavedComponentTick& savedComponent = saved.Components.AddDefaulted_GetRef();
+		savedComponent.Component = component;
+		ThrottleTick(component->PrimaryComponentTick, savedComponent.Tick, dormant, throttleInterval);
+	}
+}
+
+void UHL2PVSTickSubsystem::Wake(int32 index)
+{
+	const int32 slot = entityThrottleSlots[index];
+	if (slot == INDEX_NONE) { return; }
+	ABaseEntity* entity = entities[index];
+	FSavedEntityTick& saved = throttleSlots[slot];
+	if (entity->PrimaryActorTick.bCanEverTick)
+	{
+		WakeTick(entity->PrimaryActorTick, saved.Tick);
+	}
+	for (const FSavedComponentTick& savedComponent : saved.Components)
+	{
+		UActorComponent* component = savedComponent.Component.Get();
+		if (component == nullptr) { continue; }
+		WakeTick(component->PrimaryComponentTick, savedComponent.Tick);
+	}
+	saved.Tick = FSavedTick();
+	saved.Components.Reset();
+	freeThrottleSlots.Add(slot);
+	entityThrottleSlots[index] = INDEX_NONE;
+	--numThrottled;
+}
+
+void UHL2PVSTickSubsystem::ThrottleTick(FTickFunction& tick, FSavedTick& saved, bool dormant, float throttleInterval)
+{
+	saved.TickInterval = tick.TickInterval;
+	saved.ThrottledInterval = tick.TickInterval;
+	saved.DisabledTick = false;
+	if (dormant)
+	{
+		saved.DisabledTick = tick.IsTickFunctionEnabled();
+		if (saved.DisabledTick) { tick.SetTickFunctionEnable(false); }
+	}
+	else if (tick.TickInterval < throttleInterval)
+	{
+		saved.ThrottledInterval = throttleInterval;
+		tick.UpdateTickIntervalAndCoolDown(throttleInterval);
+	}
+}
+
+void UHL2PVSTickSubsystem::WakeTick(FTickFunction& tick, const FSavedTick& saved)
+{
+	// Leave anything the entity changed itself while throttled
+	if (saved.ThrottledInterval != saved.TickInterval && tick.TickInterval == saved.ThrottledInterval)
+	{
+		tick.UpdateTickIntervalAndCoolDown(saved.TickInterval);
+	}
+	if (saved.DisabledTick && !tick.IsTickFunctionEnabled())
+	{
+		tick.SetTickFunctionEnable(true);
+	}
+}
+
+void UHL2PVSTickSubsystem::WakeAll()
+{
+	if (numThrottled == 0) { return; }
+	for (int32 i = 0; i < entities.Num(); ++i)
+	{
+		Wake(i);
+	}
+}
@@ -4,15 +4,177 @@
 #include "Engine/Texture.h"
 #include "VMTMaterial.h"
 #include "EngineUtils.h"
+#include "HL2EntitySubsystem.h"
+
+const FName fnAssetRegistry(TEXT("AssetRegistry"));
 
 void HL2RuntimeImpl::StartupModule()
 {
-
+	// Keep the asset cache in step with the registry
+	IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(fnAssetRegistry).Get();
+	assetRegistry.OnAssetAdded().AddRaw(this, &HL2RuntimeImpl::OnAssetAdded);
+	assetRegistry.OnAssetRemoved().AddRaw(this, &HL2RuntimeImpl::OnAssetRemoved);
+	assetRegistry.OnAssetRenamed().AddRaw(this, &HL2RuntimeImpl::OnAssetRenamed);
 }
 
 void HL2RuntimeImpl::ShutdownModule()
 {
-	
+	if (FModuleManager::Get().IsModuleLoaded(fnAssetRegistry))
+	{
+		IAssetRegistry& assetRegistry = FModuleManager::GetModuleChecked<FAssetRegistryModule>(fnAssetRegistry).Get();
+		assetRegistry.OnAssetAdded().RemoveAll(this);
+		assetRegistry.OnAssetRemoved().RemoveAll(this);
+		assetRegistry.OnAssetRenamed().RemoveAll(this);
+	}
+	FWriteScopeLock writeLock(assetCacheLock);
+	assetCache.Empty();
+}
+
+bool HL2RuntimeImpl::TryGetCachedAsset(const FName assetPath, UObject*& outAsset) const
+{
+	FReadScopeLock readLock(assetCacheLock);
+	const FCachedAsset* cachedAsset = assetCache.Find(assetPath);
+	if (cachedAsset == nullptr) { return false; }
+	if (!cachedAsset->Exists)
+	{
+		outAsset = nullptr;
+		return true;
+	}
+	outAsset = cachedAsset->Asset.Get();
+	return outAsset != nullptr;
+}
+
+UObject* HL2RuntimeImpl::ResolveAsset(const FName assetPath) const
+{
+	UObject* asset;
+	if (TryGetCachedAsset(assetPath, asset)) { return asset; }
+
+	// The lock is not held while loading, as loading may raise registry events that need it
+	IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(fnAssetRegistry).Get();
+	const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
+	asset = assetData.IsValid() ? assetData.GetAsset() : nullptr;
+
+	FWriteScopeLock writeLock(assetCacheLock);
+	FCachedAsset& cachedAsset = assetCache.FindOrAdd(assetPath);
+	cachedAsset.Asset = asset;
+	cachedAsset.Exists = assetData.IsValid();
+	return asset;
+}
+
+void HL2RuntimeImpl::OnAssetAdded(const FAssetData& assetData)
+{
+	{
+		FWriteScopeLock writeLock(assetCacheLock);
+		assetCache.Remove(assetData.ObjectPath);
+	}
+	if (assetData.AssetClass == UVMTMaterial::StaticClass()->GetFName())
+	{
+		FWriteScopeLock writeLock(textureIndexLock);
+		if (textureIndexBuilt) { IndexMaterialTextures(assetData); }
+	}
+}
+
+void HL2RuntimeImpl::OnAssetRemoved(const FAssetData& assetData)
+{
+	{
+		FWriteScopeLock writeLock(assetCacheLock);
+		assetCache.Remove(assetData.ObjectPath);
+	}
+	if (assetData.AssetClass == UVMTMaterial::StaticClass()->GetFName())
+	{
+		FWriteScopeLock writeLock(textureIndexLock);
+		UnindexMaterialTextures(assetData.ObjectPath);
+	}
+}
+
+void HL2RuntimeImpl::OnAssetRenamed(const FAssetData& assetData, const FString& oldObjectPath)
+{
+	const FName oldObjectPathName(*oldObjectPath);
+	{
+		FWriteScopeLock writeLock(assetCacheLock);
+		assetCache.Remove(assetData.ObjectPath);
+		assetCache.Remove(oldObjectPathName);
+	}
+	if (assetData.AssetClass == UVMTMaterial::StaticClass()->GetFName())
+	{
+		FWriteScopeLock writeLock(textureIndexLock);
+		UnindexMaterialTextures(oldObjectPathName);
+		if (textureIndexBuilt) { IndexMaterialTextures(assetData); }
+	}
+}
+
+void HL2RuntimeImpl::EnsureTextureIndex() const
+{
+	{
+		FReadScopeLock readLock(textureIndexLock);
+		if (textureIndexBuilt) { return; }
+	}
+	IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(fnAssetRegistry).Get();
+	TArray<FAssetData> assets;
+	assetRegistry.GetAssetsByClass(UVMTMaterial::StaticClass()->GetFName(), assets);
+
+	// Gather outside the lock, as loading may raise registry events that need it
+	TMap<FName, TArray<FName>> gathered;
+	gathered.Reserve(assets.Num());
+	for (const FAssetData& assetData : assets)
+	{
+		FString tagValue;
+		if (assetData.GetTagValue(UVMTMaterial::TexturesTagName, tagValue))
+		{
+			UVMTMaterial::ParseTexturesTag(tagValue, gathered.Add(assetData.ObjectPath));
+			continue;
+		}
+
+		// Saved before the textures tag existed, so the material has to be loaded once to find out
+		const UVMTMaterial* material = Cast<UVMTMaterial>(assetData.GetAsset());
+		if (material == nullptr) { continue; }
+		TArray<FName>& textures = gathered.Add(assetData.ObjectPath);
+		for (const auto& pair : material->vmtTextures)
+		{
+			if (pair.Value.IsNone()) { continue; }
+			textures.AddUnique(pair.Value);
+		}
+	}
+
+	FWriteScopeLock writeLock(textureIndexLock);
+	if (textureIndexBuilt) { return; }
+	for (auto& pair : gathered)
+	{
+		UnindexMaterialTextures(pair.Key);
+		for (const FName texture : pair.Value)
+		{
+			materialsByTexture.FindOrAdd(texture).Add(pair.Key);
+		}
+		texturesByMaterial.Add(pair.Key, MoveTemp(pair.Value));
+	}
+	textureIndexBuilt = true;
+}
+
+bool HL2RuntimeImpl::IndexMaterialTextures(const FAssetData& assetData) const
+{
+	FString tagValue;
+	if (!assetData.GetTagValue(UVMTMaterial::TexturesTagName, tagValue)) { return false; }
+	UnindexMaterialTextures(assetData.ObjectPath);
+	TArray<FName>& textures = texturesByMaterial.Add(assetData.ObjectPath);
+	UVMTMaterial::ParseTexturesTag(tagValue, textures);
+	for (const FName texture : textures)
+	{
+		materialsByTexture.FindOrAdd(texture).Add(assetData.ObjectPath);
+	}
+	return true;
+}
+
+void HL2RuntimeImpl::UnindexMaterialTextures(const FName materialPath) const
+{
+	TArray<FName> textures;
+	if (!texturesByMaterial.RemoveAndCopyValue(materialPath, textures)) { return; }
+	for (const FName texture : textures)
+	{
+		TArray<FName>* materials = materialsByTexture.Find(texture);
+		if (materials == nullptr) { continue; }
+		materials->RemoveSwap(materialPath);
+		if (materials->Num() == 0) { materialsByTexture.Remove(texture); }
+	}
 }
 
 FName HL2RuntimeImpl::HL2TexturePathToAssetPath(const FString& hl2TexturePath) const
@@ -62,96 +224,131 @@ FName HL2RuntimeImpl::HL2ShaderPathToAssetPath(const FString& hl2ShaderPath, boo
 
 UTexture* HL2RuntimeImpl::TryResolveHL2Texture(const FString& hl2TexturePath) const
 {
-	const FName assetPath = HL2TexturePathToAssetPath(hl2TexturePath);
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
-	const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-	if (!assetData.IsValid()) { return nullptr; }
-	return CastChecked<UTexture>(assetData.GetAsset());
+	UObject* asset = ResolveAsset(HL2TexturePathToAssetPath(hl2TexturePath));
+	return asset != nullptr ? CastChecked<UTexture>(asset) : nullptr;
 }
 
 UMaterialInterface* HL2RuntimeImpl::TryResolveHL2Material(const FString& hl2MaterialPath) const
 {
-	const FName assetPath = HL2MaterialPathToAssetPath(hl2MaterialPath);
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
-	const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-	if (!assetData.IsValid()) { return nullptr; }
-	return CastChecked<UMaterialInterface>(assetData.GetAsset());
+	UObject* asset = ResolveAsset(HL2MaterialPathToAssetPath(hl2MaterialPath));
+	return asset != nullptr ? CastChecked<UMaterialInterface>(asset) : nullptr;
 }
 
 UStaticMesh* HL2RuntimeImpl::TryResolveHL2StaticProp(const FString& hl2ModelPath) const
 {
-	const FName assetPath = HL2ModelPathToAssetPath(hl2ModelPath);
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
-	const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-	if (!assetData.IsValid()) { return nullptr; }
+	UObject* asset = ResolveAsset(HL2ModelPathToAssetPath(hl2ModelPath));
 	// It might not be a UStaticMesh if the model is animated, so let Cast just return nullptr in this case
-	return Cast<UStaticMesh>(assetData.GetAsset());
+	return Cast<UStaticMesh>(asset);
 }
 
 USkeletalMesh* HL2RuntimeImpl::TryResolveHL2AnimatedProp(const FString& hl2ModelPath) const
 {
-	const FName assetPath = HL2ModelPathToAssetPath(hl2ModelPath);
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
-	const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-	if (!assetData.IsValid()) { return nullptr; }
+	UObject* asset = ResolveAsset(HL2ModelPathToAssetPath(hl2ModelPath));
 	// It might not be a USkeletalMesh if the model is not animated, so let Cast just return nullptr in this case
-	return Cast<USkeletalMesh>(assetData.GetAsset());
+	return Cast<USkeletalMesh>(asset);
+}
+
+UStaticMesh* HL2RuntimeImpl::TryResolveHL2RigidProp(const FString& hl2ModelPath) const
+{
+	// e.g. "models/props_c17/oildrum001.mdl" -> "/Game/hl2/models/props_c17/oildrum001_static.oildrum001_static"
+	UObject* asset = ResolveAsset(HL2ModelPathToAssetPath(FPaths::GetBaseFilename(hl2ModelPath, false) + TEXT("_static")));
+	return Cast<UStaticMesh>(asset);
 }
 
 USoundWave* HL2RuntimeImpl::TryResolveHL2Sound(const FString& hl2SoundPath) const
 {
-	const FName assetPath = HL2SoundPathToAssetPath(hl2SoundPath);
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
-	const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-	if (!assetData.IsValid()) { return nullptr; }
-	return Cast<USoundWave>(assetData.GetAsset());
+	UObject* asset = ResolveAsset(HL2SoundPathToAssetPath(hl2SoundPath));
+	return Cast<USoundWave>(asset);
 }
 
 UObject* HL2RuntimeImpl::TryResolveHL2Script(const FString& hl2ScriptPath) const
 {
-	const FName assetPath = HL2ScriptPathToAssetPath(hl2ScriptPath);
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
-	const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-	if (!assetData.IsValid()) { return nullptr; }
-	return assetData.GetAsset();
+	return ResolveAsset(HL2ScriptPathToAssetPath(hl2ScriptPath));
 }
 
 USurfaceProp* HL2RuntimeImpl::TryResolveHL2SurfaceProp(const FName& surfaceProp) const
 {
-	const FName assetPath = HL2SurfacePropToAssetPath(surfaceProp);
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
-	const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-	if (!assetData.IsValid()) { return nullptr; }
-	return Cast<USurfaceProp>(assetData.GetAsset());
+	UObject* asset = ResolveAsset(HL2SurfacePropToAssetPath(surfaceProp));
+	return Cast<USurfaceProp>(asset);
 }
 
 UMaterial* HL2RuntimeImpl::TryResolveHL2Shader(const FString& hl2ShaderPath, bool searchGameFirst) const
 {
 	UObject* asset = nullptr;
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
 	if (searchGameFirst)
 	{
-		const FName assetPath = HL2ShaderPathToAssetPath(hl2ShaderPath, false);
-		const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-		if (assetData.IsValid()) { asset = assetData.GetAsset(); }
+		asset = ResolveAsset(HL2ShaderPathToAssetPath(hl2ShaderPath, false));
 	}
 	if (asset == nullptr)
 	{
-		const FName assetPath = HL2ShaderPathToAssetPath(hl2ShaderPath, true);
-		const FAssetData assetData = assetRegistry.GetAssetByObjectPath(assetPath);
-		if (assetData.IsValid()) { asset = assetData.GetAsset(); }
+		asset = ResolveAsset(HL2ShaderPathToAssetPath(hl2ShaderPath, true));
 	}
 	return asset != nullptr ? CastChecked<UMaterial>(asset) : nullptr;
 }
 
+void HL2RuntimeImpl::TryResolveAssets(TArrayView<const FName> assetPaths, TArray<UObject*>& outAssets) const
+{
+	outAssets.SetNumZeroed(assetPaths.Num());
+
+	// Serve what we can from the cache
+	TArray<int32> uncachedIndices;
+	FARFilter filter;
+	for (int32 i = 0; i < assetPaths.Num(); ++i)
+	{
+		if (TryGetCachedAsset(assetPaths[i], outAssets[i])) { continue; }
+		uncachedIndices.Add(i);
+		filter.ObjectPaths.Add(assetPaths[i]);
+	}
+	if (uncachedIndices.Num() == 0) { return; }
+
+	// Query the registry once for everything else
+	IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(fnAssetRegistry).Get();
+	TArray<FAssetData> assetDatas;
+	assetRegistry.GetAssets(filter, assetDatas);
+	TMap<FName, const FAssetData*> assetDatasByPath;
+	assetDatasByPath.Reserve(assetDatas.Num());
+	for (const FAssetData& assetData : assetDatas)
+	{
+		assetDatasByPath.Add(assetData.ObjectPath, &assetData);
+	}
+	TArray<bool> exists;
+	exists.SetNumZeroed(uncachedIndices.Num());
+	for (int32 i = 0; i < uncachedIndices.Num(); ++i)
+	{
+		const int32 index = uncachedIndices[i];
+		const FAssetData* const* assetData = assetDatasByPath.Find(assetPaths[index]);
+		if (assetData == nullptr) { continue; }
+		exists[i] = true;
+		outAssets[index] = (*assetData)->GetAsset();
+	}
+
+	FWriteScopeLock writeLock(assetCacheLock);
+	for (int32 i = 0; i < uncachedIndices.Num(); ++i)
+	{
+		const int32 index = uncachedIndices[i];
+		FCachedAsset& cachedAsset = assetCache.FindOrAdd(assetPaths[index]);
+		cachedAsset.Asset = outAssets[index];
+		cachedAsset.Exists = exists[i];
+	}
+}
+
+void HL2RuntimeImpl::TryResolveHL2Materials(TArrayView<const FString> hl2MaterialPaths, TArray<UMaterialInterface*>& outMaterials) const
+{
+	TArray<FName> assetPaths;
+	assetPaths.Reserve(hl2MaterialPaths.Num());
+	for (const FString& hl2MaterialPath : hl2MaterialPaths)
+	{
+		assetPaths.Add(HL2MaterialPathToAssetPath(hl2MaterialPath));
+	}
+	TArray<UObject*> assets;
+	TryResolveAssets(assetPaths, assets);
+	outMaterials.Reset(assets.Num());
+	for (UObject* asset : assets)
+	{
+		outMaterials.Add(asset != nullptr ? CastChecked<UMaterialInterface>(asset) : nullptr);
+	}
+}
+
 void HL2RuntimeImpl::FindAllMaterialsThatReferenceTexture(const FString& hl2TexturePath, TArray<UMaterialInterface*>& out) const
 {
 	FindAllMaterialsThatReferenceTexture(HL2TexturePathToAssetPath(hl2TexturePath), out);
@@ -159,13 +356,14 @@ void HL2RuntimeImpl::FindAllMaterialsThatReferenceTexture(const FString& hl2Text
 
 void HL2RuntimeImpl::FindAllMaterialsThatReferenceTexture(FName assetPath, TArray<UMaterialInterface*>& out) const
 {
-	FAssetRegistryModule& assetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
-	IAssetRegistry& assetRegistry = assetRegistryModule.Get();
-	TArray<FAssetData> assets;
-	assetRegistry.GetAssetsByClass(UVMTMaterial::StaticClass()->GetFName(), assets);
-	for (const FAssetData& assetData : assets)
+	// Only the materials that actually reference the texture get loaded
+	TArray<FName> materialPaths;
+	FindAllMaterialPathsThatReferenceTexture(assetPath, materialPaths);
+	TArray<UObject*> assets;
+	TryResolveAssets(materialPaths, assets);
+	for (UObject* asset : assets)
 	{
-		UVMTMaterial* material = Cast<UVMTMaterial>(assetData.GetAsset());
+		UVMTMaterial* material = Cast<UVMTMaterial>(asset);
 		if (material && material->DoesReferenceTexture(assetPath))
 		{
 			out.Add(CastChecked<UMaterialInterface>(material));
@@ -173,52 +371,29 @@ void HL2RuntimeImpl::FindAllMaterialsThatReferenceTexture(FName assetPath, TArra
 	}
 }
 
-void HL2RuntimeImpl::FindEntitiesByTargetName(UWorld* world, const FName targetName, TArray<ABaseEntity*>& outEntities) const
+void HL2RuntimeImpl::FindAllMaterialPathsThatReferenceTexture(FName assetPath, TArray<FName>& outMaterialPaths) const
 {
-	// Determine if wildcard
-	FString targetNameStr;
-	targetName.ToString(targetNameStr);
-	bool isWildcard;
-	if (targetNameStr.EndsWith(TEXT("*")))
-	{
-		targetNameStr.RemoveAt(targetNameStr.Len() - 1);
-		isWildcard = true;
-	}
-	else
-	{
-		isWildcard = false;
-	}
+	EnsureTextureIndex();
+	FReadScopeLock readLock(textureIndexLock);
+	const TArray<FName>* materials = materialsByTexture.Find(assetPath);
+	if (materials == nullptr) { return; }
+	outMaterialPaths.Append(*materials);
+}
 
-	// Iterate all entities
-	FString tmpName;
-	for (TActorIterator<ABaseEntity> it(world); it; ++it)
-	{
-		ABaseEntity* entity = *it;
+void HL2RuntimeImpl::NotifyMaterialTexturesChanged(const UMaterialInterface* material)
+{
+	if (material == nullptr || !material->IsA<UVMTMaterial>()) { return; }
+	FWriteScopeLock writeLock(textureIndexLock);
+	if (!textureIndexBuilt) { return; }
+	IndexMaterialTextures(FAssetData(material));
+}
 
-		// Handle simple equals case first
-		if (entity->TargetName == targetName)
-		{
-			outEntities.Add(entity);
-		}
-		else if (entity->EntityData.Classname == targetName)
-		{
-			outEntities.Add(entity);
-		}
-		// Handle wildcard case
-		else if (isWildcard)
-		{
-			entity->TargetName.ToString(tmpName);
-			if (tmpName.Len() > targetNameStr.Len())
-			{
-				tmpName.RemoveAt(targetNameStr.Len(), tmpName.Len() - targetNameStr.Len());
-				if (tmpName.Equals(targetNameStr, ESearchCase::IgnoreCase))
-				{
-					outEntities.Add(entity);
-				}
-			}
-			
-		}
-	}
+void HL2RuntimeImpl::FindEntitiesByTargetName(UWorld* world, const FName targetName, TArray<ABaseEntity*>& outEntities) const
+{
+	if (world == nullptr) { return; }
+	const UHL2EntitySubsystem* entitySubsystem = world->GetSubsystem<UHL2EntitySubsystem>();
+	if (entitySubsystem == nullptr) { return; }
+	entitySubsystem->FindEntitiesByTargetName(targetName, outEntities);
 }
 
 IMPLEMENT_MODULE(HL2RuntimeImpl, HL2Runtime)
\ No newline at end of file
@@ -34,10 +34,47 @@ private:
 	const FString pluginShaderBasePath = pluginBasePath + "Shaders/";
 	const FString pluginEntityBasePath = pluginBasePath + "Entities/";
 
+	/** An asset path looked up through the asset registry. Assets that exist but have been unloaded are looked up again. */
+	struct FCachedAsset
+	{
+		TWeakObjectPtr<UObject> Asset;
+		bool Exists = false;
+	};
+
+	// Keyed by asset path, which is the normalised form of the hl2 path (unified separators, case insensitive)
+	mutable TMap<FName, FCachedAsset> assetCache;
+	mutable FRWLock assetCacheLock;
+
+	// Reverse index of texture asset path to the vmt materials that reference it, built lazily from asset registry tags
+	mutable TMap<FName, TArray<FName>> materialsByTexture;
+	mutable TMap<FName, TArray<FName>> texturesByMaterial;
+	mutable bool textureIndexBuilt = false;
+	mutable FRWLock textureIndexLock;
+
 private:
 
 	static inline FName SourceToUnrealPath(const FString& basePath, const FString& sourcePath);
 
+	/** Resolves an asset path through the cache, loading the asset if needed. Thread safe, but loading must happen on the game thread. */
+	UObject* ResolveAsset(const FName assetPath) const;
+
+	bool TryGetCachedAsset(const FName assetPath, UObject*& outAsset) const;
+
+	void OnAssetAdded(const FAssetData& assetData);
+
+	void OnAssetRemoved(const FAssetData& assetData);
+
+	void OnAssetRenamed(const FAssetData& assetData, const FString& oldObjectPath);
+
+	/** Builds the texture reference index from the asset registry if it has not been built yet. */
+	void EnsureTextureIndex() const;
+
+	/** Adds or replaces the index entry of a vmt material. Returns false if the asset has no textures tag. Assumes textureIndexLock is held for writing. */
+	bool IndexMaterialTextures(const FAssetData& assetData) const;
+
+	/** Removes the index entry of a vmt material. Assumes textureIndexLock is held for writing. */
+	void UnindexMaterialTextures(const FName materialPath) const;
+
 public:
 
 	/** Begin IHL2Runtime implementation */
@@ -66,14 +103,22 @@ public:
 	virtual UMaterialInterface* TryResolveHL2Material(const FString& hl2TexturePath) const override;
 	virtual UStaticMesh* TryResolveHL2StaticProp(const FString& hl2ModelPath) const override;
 	virtual USkeletalMesh* TryResolveHL2AnimatedProp(const FString& hl2ModelPath) const override;
+	virtual UStaticMesh* TryResolveHL2RigidProp(const FString& hl2ModelPath) const override;
 	virtual USoundWave* TryResolveHL2Sound(const FString& hl2SoundPath) const override;
 	virtual UObject* TryResolveHL2Script(const FString& hl2ScriptPath) const override;
 	virtual USurfaceProp* TryResolveHL2SurfaceProp(const FName& surfaceProp) const override;
 	virtual UMaterial* TryResolveHL2Shader(const FString& hl2ShaderPath, bool searchGameFirst = true) const override;
+
+	virtual void TryResolveAssets(TArrayView<const FName> assetPaths, TArray<UObject*>& outAssets) const override;
+	virtual void TryResolveHL2Materials(TArrayView<const FString> hl2MaterialPaths, TArray<UMaterialInterface*>& outMaterials) const override;
 	
 	virtual void FindAllMaterialsThatReferenceTexture(const FString& hl2TexturePath, TArray<UMaterialInterface*>& out) const override;
 	virtual void FindAllMaterialsThatReferenceTexture(FName assetPath, TArray<UMaterialInterface*>& out) const override;
 
+	virtual void FindAllMaterialPathsThatReferenceTexture(FName assetPath, TArray<FName>& outMaterialPaths) const override;
+
+	virtual void NotifyMaterialTexturesChanged(const UMaterialInterface* material) override;
+
 	/* Supports wildcards and classnames. */
 	virtual void FindEntitiesByTargetName(UWorld* world, const FName targetName, TArray<ABaseEntity*>& outEntities) const override;
 
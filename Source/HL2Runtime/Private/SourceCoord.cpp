@@ -1,2 +1,120 @@
 #include "SourceCoord.h"
 
+namespace
+{
+	constexpr int32 laneCount = 4;
+
+	/** Loads up to four vectors into one register per component, padding unused lanes with zero. */
+	FORCEINLINE void LoadLanes(const FVector3f* vectors, int32 count, VectorRegister4Float (&outLanes)[3])
+	{
+		alignas(16) float components[3][laneCount] = {};
+		for (int32 lane = 0; lane < count; ++lane)
+		{
+			components[0][lane] = vectors[lane].X;
+			components[1][lane] = vectors[lane].Y;
+			components[2][lane] = vectors[lane].Z;
+		}
+		outLanes[0] = VectorLoadAligned(components[0]);
+		outLanes[1] = VectorLoadAligned(components[1]);
+		outLanes[2] = VectorLoadAligned(components[2]);
+	}
+
+	/** Stores the first count lanes of one register per component back into vectors. */
+	FORCEINLINE void StoreLanes(const VectorRegister4Float (&lanes)[3], int32 count, FVector3f* outVectors)
+	{
+		alignas(16) float components[3][laneCount];
+		VectorStoreAligned(lanes[0], components[0]);
+		VectorStoreAligned(lanes[1], components[1]);
+		VectorStoreAligned(lanes[2], components[2]);
+		for (int32 lane = 0; lane < count; ++lane)
+		{
+			outVectors[lane] = FVector3f(components[0][lane], components[1][lane], components[2][lane]);
+		}
+	}
+}
+
+void FSourceCoord::Positions(TArrayView<const FVector3f> inPositions, TArrayView<FVector3f> outPositions) const
+{
+	check(inPositions.Num() == outPositions.Num());
+	const int32 num = inPositions.Num();
+	if (!isAxisPermutation)
+	{
+		for (int32 i = 0; i < num; ++i)
+		{
+			outPositions[i] = transform.TransformPosition(inPositions[i]);
+		}
+		return;
+	}
+
+	// Four positions at a time, one component per register, so the permutation is a choice of register rather than a shuffle
+	const VectorRegister4Float scale[3] = { VectorSetFloat1(axisScale.X), VectorSetFloat1(axisScale.Y), VectorSetFloat1(axisScale.Z) };
+	for (int32 base = 0; base < num; base += laneCount)
+	{
+		const int32 count = FMath::Min(laneCount, num - base);
+		VectorRegister4Float in[3];
+		LoadLanes(inPositions.GetData() + base, count, in);
+		const VectorRegister4Float out[3] =
+		{
+			VectorMultiply(in[axisPermutation[0]], scale[0]),
+			VectorMultiply(in[axisPermutation[1]], scale[1]),
+			VectorMultiply(in[axisPermutation[2]], scale[2])
+		};
+		StoreLanes(out, count, outPositions.GetData() + base);
+	}
+}
+
+void FSourceCoord::Directions(TArrayView<const FVector3f> inDirections, TArrayView<FVector3f> outDirections) const
+{
+	check(inDirections.Num() == outDirections.Num());
+	const int32 num = inDirections.Num();
+	if (!isAxisPermutation)
+	{
+		for (int32 i = 0; i < num; ++i)
+		{
+			outDirections[i] = transform.TransformVector(inDirections[i]).GetSafeNormal();
+		}
+		return;
+	}
+
+	const VectorRegister4Float scale[3] = { VectorSetFloat1(axisScale.X), VectorSetFloat1(axisScale.Y), VectorSetFloat1(axisScale.Z) };
+	for (int32 base = 0; base < num; base += laneCount)
+	{
+		const int32 count = FMath::Min(laneCount, num - base);
+		VectorRegister4Float in[3];
+		LoadLanes(inDirections.GetData() + base, count, in);
+		VectorRegister4Float out[3] =
+		{
+			VectorMultiply(in[axisPermutation[0]], scale[0]),
+			VectorMultiply(in[axisPermutation[1]], scale[1]),
+			VectorMultiply(in[axisPermutation[2]], scale[2])
+		};
+		SafeNormalLanes(out[0], out[1], out[2]);
+		StoreLanes(out, count, outDirections.GetData() + base);
+	}
+}
+
+void FSourceCoord::Quats(TArrayView<const FQuat4f> inQuats, TArrayView<FQuat4f> outQuats) const
+{
+	check(inQuats.Num() == outQuats.Num());
+
+	// The same product FQuat4f::operator* computes, without reloading the rotation each time
+	const FQuat4f rotation = transform.GetRotation();
+	const VectorRegister4Float rotationLanes = VectorLoadAligned(&rotation.X);
+	const int32 num = inQuats.Num();
+	for (int32 i = 0; i < num; ++i)
+	{
+		VectorStoreAligned(VectorQuaternionMultiply2(rotationLanes, VectorLoadAligned(&inQuats[i].X)), &outQuats[i].X);
+	}
+}
+
+void FSourceCoord::Transforms(TArrayView<const FTransform3f> inTransforms, TArrayView<FTransform3f> outTransforms) const
+{
+	check(inTransforms.Num() == outTransforms.Num());
+
+	// FTransform3f composition is already vectorised, and takes a matrix path for the mirrored conversions that has no cheaper equivalent
+	const int32 num = inTransforms.Num();
+	for (int32 i = 0; i < num; ++i)
+	{
+		outTransforms[i] = Transform(inTransforms[i]);
+	}
+}
@@ -0,0 +1,212 @@
+#include "HL2RuntimePrivatePCH.h"
+
+#include "Misc/AutomationTest.h"
+#include "SourceCoord.h"
+
+BEGIN_DEFINE_SPEC(SourceCoordSpec, "HL2.SourceCoord.Spec", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+TArray<FVector3f> Vectors;
+TArray<FQuat4f> Rotations;
+void MakeVectors();
+void MakeRotations();
+void TestPositionsMatch(const FSourceCoord& coord);
+void TestDirectionsMatch(const FSourceCoord& coord);
+END_DEFINE_SPEC(SourceCoordSpec)
+
+void SourceCoordSpec::MakeVectors()
+{
+	// An odd count so the last batch doesn't fill every lane, plus the edge cases of GetSafeNormal
+	FRandomStream random(1234);
+	Vectors.Reset();
+	Vectors.Add(FVector3f::ZeroVector);
+	Vectors.Add(FVector3f(1.0f, 0.0f, 0.0f));
+	Vectors.Add(FVector3f(0.0f, -1.0f, 0.0f));
+	Vectors.Add(FVector3f(0.0f, 0.0f, 1e-5f));
+	Vectors.Add(FVector3f(-0.0f, 0.0f, -0.0f));
+	for (int32 i = 0; i < 250; ++i)
+	{
+		const float magnitude = FMath::Pow(10.0f, random.FRandRange(-4.0f, 5.0f));
+		Vectors.Add(FVector3f(random.FRandRange(-1.0f, 1.0f), random.FRandRange(-1.0f, 1.0f), random.FRandRange(-1.0f, 1.0f)) * magnitude);
+	}
+}
+
+void SourceCoordSpec::MakeRotations()
+{
+	FRandomStream random(5678);
+	Rotations.Reset();
+	Rotations.Add(FQuat4f::Identity);
+	for (int32 i = 0; i < 63; ++i)
+	{
+		Rotations.Add(FQuat4f(FRotator3f(random.FRandRange(-180.0f, 180.0f), random.FRandRange(-180.0f, 180.0f), random.FRandRange(-180.0f, 180.0f))));
+	}
+}
+
+void SourceCoordSpec::TestPositionsMatch(const FSourceCoord& coord)
+{
+	TArray<FVector3f> batched;
+	batched.SetNumUninitialized(Vectors.Num());
+	coord.Positions(Vectors, batched);
+	for (int32 i = 0; i < Vectors.Num(); ++i)
+	{
+		const FVector3f single = coord.Position(Vectors[i]);
+		if (single != batched[i])
+		{
+			AddError(FString::Printf(TEXT("Position %d: batched %s != single %s"), i, *batched[i].ToString(), *single.ToString()));
+			return;
+		}
+	}
+}
+
+void SourceCoordSpec::TestDirectionsMatch(const FSourceCoord& coord)
+{
+	TArray<FVector3f> batched;
+	batched.SetNumUninitialized(Vectors.Num());
+	coord.Directions(Vectors, batched);
+	for (int32 i = 0; i < Vectors.Num(); ++i)
+	{
+		const FVector3f single = coord.Direction(Vectors[i]);
+		if (single != batched[i])
+		{
+			AddError(FString::Printf(TEXT("Direction %d: batched %s != single %s"), i, *batched[i].ToString(), *single.ToString()));
+			return;
+		}
+	}
+}
+
+void SourceCoordSpec::Define()
+{
+	Describe("FSourceCoord", [this]()
+		{
+			BeforeEach([this]()
+				{
+					MakeVectors();
+					MakeRotations();
+				});
+
+			Describe("IsAxisPermutation", [this]()
+				{
+					It("will be true for the built-in conversions", [this]()
+						{
+							TestTrue("SourceToUnreal", SourceToUnreal.IsAxisPermutation());
+							TestTrue("StudioMdlToUnreal", StudioMdlToUnreal.IsAxisPermutation());
+							TestTrue("UnrealToSource", UnrealToSource.IsAxisPermutation());
+							TestTrue("UnrealToStudioMdl", UnrealToStudioMdl.IsAxisPermutation());
+						});
+
+					It("will be false for rotations and non-uniform scales", [this]()
+						{
+							const FSourceCoord rotated(FVector3f(0.6f, 0.8f, 0.0f), FVector3f(-0.8f, 0.6f, 0.0f), FVector3f(0.0f, 0.0f, 1.0f));
+							TestFalse("rotated", rotated.IsAxisPermutation());
+							const FSourceCoord stretched(FVector3f(2.0f, 0.0f, 0.0f), FVector3f(0.0f, 1.0f, 0.0f), FVector3f(0.0f, 0.0f, 1.0f));
+							TestFalse("stretched", stretched.IsAxisPermutation());
+						});
+				});
+
+			Describe("Positions", [this]()
+				{
+					It("will exactly match Position for the built-in conversions", [this]()
+						{
+							TestPositionsMatch(SourceToUnreal);
+							TestPositionsMatch(StudioMdlToUnreal);
+							TestPositionsMatch(UnrealToSource);
+							TestPositionsMatch(UnrealToStudioMdl);
+						});
+
+					It("will exactly match Position for a general conversion", [this]()
+						{
+							TestPositionsMatch(FSourceCoord(FVector3f(0.6f, 0.8f, 0.0f), FVector3f(-0.8f, 0.6f, 0.0f), FVector3f(0.0f, 0.0f, 1.0f)));
+						});
+
+					It("will agree with the general transform", [this]()
+						{
+							for (const FVector3f& vector : Vectors)
+							{
+								const FVector3f expected = SourceToUnreal.GetTransform().TransformPosition(vector);
+								const FVector3f actual = SourceToUnreal.Position(vector);
+								if (!actual.Equals(expected, FMath::Max(1e-3f, expected.GetAbsMax() * 1e-5f)))
+								{
+									AddError(FString::Printf(TEXT("Position of %s: %s, expected %s"), *vector.ToString(), *actual.ToString(), *expected.ToString()));
+									return;
+								}
+							}
+						});
+
+					It("will convert in place", [this]()
+						{
+							TArray<FVector3f> vectors = Vectors;
+							StudioMdlToUnreal.Positions(vectors, vectors);
+							for (int32 i = 0; i < Vectors.Num(); ++i)
+							{
+								TestEqual(TEXT("Position"), vectors[i], StudioMdlToUnreal.Position(Vectors[i]));
+							}
+						});
+				});
+
+			Describe("Directions", [this]()
+				{
+					It("will exactly match Direction for the built-in conversions", [this]()
+						{
+							TestDirectionsMatch(SourceToUnreal);
+							TestDirectionsMatch(StudioMdlToUnreal);
+							TestDirectionsMatch(UnrealToSource);
+							TestDirectionsMatch(UnrealToStudioMdl);
+						});
+
+					It("will exactly match Direction for a general conversion", [this]()
+						{
+							TestDirectionsMatch(FSourceCoord(FVector3f(0.6f, 0.8f, 0.0f), FVector3f(-0.8f, 0.6f, 0.0f), FVector3f(0.0f, 0.0f, 1.0f)));
+						});
+
+					It("will agree with the general transform", [this]()
+						{
+							for (const FVector3f& vector : Vectors)
+							{
+								const FVector3f expected = StudioMdlToUnreal.GetTransform().TransformVector(vector).GetSafeNormal();
+								const FVector3f actual = StudioMdlToUnreal.Direction(vector);
+								if (!actual.Equals(expected, 1e-5f))
+								{
+									AddError(FString::Printf(TEXT("Direction of %s: %s, expected %s"), *vector.ToString(), *actual.ToString(), *expected.ToString()));
+									return;
+								}
+							}
+						});
+				});
+
+			Describe("Quats", [this]()
+				{
+					It("will exactly match Quat", [this]()
+						{
+							TArray<FQuat4f> batched;
+							batched.SetNumUninitialized(Rotations.Num());
+							StudioMdlToUnreal.Quats(Rotations, batched);
+							for (int32 i = 0; i < Rotations.Num(); ++i)
+							{
+								const FQuat4f single = StudioMdlToUnreal.Quat(Rotations[i]);
+								if (single.X != batched[i].X || single.Y != batched[i].Y || single.Z != batched[i].Z || single.W != batched[i].W)
+								{
+									AddError(FString::Printf(TEXT("Quat %d: batched %s != single %s"), i, *batched[i].ToString(), *single.ToString()));
+									return;
+								}
+							}
+						});
+				});
+
+			Describe("Transforms", [this]()
+				{
+					It("will exactly match Transform", [this]()
+						{
+							TArray<FTransform3f> transforms;
+							for (int32 i = 0; i < Rotations.Num(); ++i)
+							{
+								transforms.Add(FTransform3f(Rotations[i], Vectors[i], FVector3f(1.0f + i * 0.01f)));
+							}
+							TArray<FTransform3f> batched;
+							batched.SetNumUninitialized(transforms.Num());
+							StudioMdlToUnreal.Transforms(transforms, batched);
+							for (int32 i = 0; i < transforms.Num(); ++i)
+							{
+								TestTrue(TEXT("Transform"), StudioMdlToUnreal.Transform(transforms[i]).Equals(batched[i], 0.0f));
+							}
+						});
+				});
+		});
+}
@@ -4,23 +4,134 @@
 #include "Engine/StaticMeshActor.h"
 #include "Engine/World.h"
 #include "EngineUtils.h"
+#include "Engine/Polys.h"
+#include "Async/ParallelFor.h"
+#include "SourceCoord.h"
+
+// Hulls stop this far short of a brush surface, 1/32 of a Source unit, so that the next trace never starts inside it
+static constexpr float TraceDistEpsilon = 0.03125f * SOURCE_UNIT_SCALE;
+
+/** The state of a single hull trace, kept on the stack for the duration of the trace. */
+struct AVBSPInfo::FTraceWork
+{
+	FVector3f Start;
+	FVector3f End;
+	FVector3f Extents;
+	int32 ContentsMask;
+	bool IsRay;
+	FVBSPTraceResult Result;
+};
 
 /** Gets the leaf that contains the position, or -1 if the position is outside the BSP tree. */
 int AVBSPInfo::FindLeaf(const FVector3f& pos) const
 {
 	if (Nodes.Num() == 0) { return -1; }
 	int curNodeID = 0;
-	FVector3f flippedPos = pos * FVector3f(1.0f, -1.0f, 1.0f);
 	while (curNodeID >= 0)
 	{
 		check(curNodeID < Nodes.Num());
 		const FVBSPNode& node = Nodes[curNodeID];
 		const bool isFront = node.Plane.PlaneDot(pos) >= 0.0f;
-		curNodeID = isFront ? node.Right : node.Left;
+		curNodeID = isFront ? node.Front : node.Back;
 	}
 	return NodeIDToLeafID(curNodeID);
 }
 
+/**
+ * Gets the leaves that contain each of the positions, or -1 for positions outside the BSP tree.
+ * On entry, outLeaves may hold the leaf last found for each position (or -1), for example one slot per actor kept between frames.
+ * Positions still inside their previous leaf only have that leaf's bounding planes tested, the rest are traversed four at a time.
+ * Points lying exactly on a plane shared between two leaves may report either leaf.
+ */
+void AVBSPInfo::FindLeaves(TArrayView<const FVector> positions, TArrayView<int32> outLeaves) const
+{
+	check(positions.Num() == outLeaves.Num());
+	if (Nodes.Num() == 0)
+	{
+		for (int32& leaf : outLeaves) { leaf = -1; }
+		return;
+	}
+
+	constexpr int32 laneCount = 4;
+	constexpr uint32 allLanes = (1 << laneCount) - 1;
+	const FVBSPNode* nodes = Nodes.GetData();
+	const int32 num = positions.Num();
+	for (int32 base = 0; base < num; base += laneCount)
+	{
+		// Set up lanes, retiring any position that is still within its previous leaf
+		int32 curNodeIDs[laneCount];
+		FVector3f lanePos[laneCount];
+		uint32 activeMask = 0;
+		for (int32 lane = 0; lane < laneCount; ++lane)
+		{
+			const int32 index = base + lane;
+			curNodeIDs[lane] = 0;
+			if (index >= num)
+			{
+				lanePos[lane] = FVector3f::ZeroVector;
+				continue;
+			}
+			lanePos[lane] = FVector3f(positions[index]);
+			if (IsInLeaf(lanePos[lane], outLeaves[index])) { continue; }
+			activeMask |= 1 << lane;
+		}
+		if (activeMask == 0) { continue; }
+
+		const VectorRegister4Float posX = MakeVectorRegisterFloat(lanePos[0].X, lanePos[1].X, lanePos[2].X, lanePos[3].X);
+		const VectorRegister4Float posY = MakeVectorRegisterFloat(lanePos[0].Y, lanePos[1].Y, lanePos[2].Y, lanePos[3].Y);
+		const VectorRegister4Float posZ = MakeVectorRegisterFloat(lanePos[0].Z, lanePos[1].Z, lanePos[2].Z, lanePos[3].Z);
+
+		// Walk all active lanes down the tree together, testing one plane per lane per step
+		while (activeMask != 0)
+		{
+			// Retired lanes keep pointing at the root so that their loads stay valid
+			const FPlane4f& p0 = nodes[(activeMask & 1) ? curNodeIDs[0] : 0].Plane;
+			const FPlane4f& p1 = nodes[(activeMask & 2) ? curNodeIDs[1] : 0].Plane;
+			const FPlane4f& p2 = nodes[(activeMask & 4) ? curNodeIDs[2] : 0].Plane;
+			const FPlane4f& p3 = nodes[(activeMask & 8) ? curNodeIDs[3] : 0].Plane;
+			VectorRegister4Float dist = VectorNegate(MakeVectorRegisterFloat(p0.W, p1.W, p2.W, p3.W));
+			dist = VectorMultiplyAdd(MakeVectorRegisterFloat(p0.X, p1.X, p2.X, p3.X), posX, dist);
+			dist = VectorMultiplyAdd(MakeVectorRegisterFloat(p0.Y, p1.Y, p2.Y, p3.Y), posY, dist);
+			dist = VectorMultiplyAdd(MakeVectorRegisterFloat(p0.Z, p1.Z, p2.Z, p3.Z), posZ, dist);
+			const uint32 frontMask = (uint32)VectorMaskBits(VectorCompareGE(dist, VectorZeroFloat())) & allLanes;
+			for (int32 lane = 0; lane < laneCount; ++lane)
+			{
+				const uint32 laneBit = 1 << lane;
+				if (!(activeMask & laneBit)) { continue; }
+				const FVBSPNode& node = nodes[curNodeIDs[lane]];
+				curNodeIDs[lane] = (frontMask & laneBit) ? node.Front : node.Back;
+				if (curNodeIDs[lane] < 0)
+				{
+					outLeaves[base + lane] = NodeIDToLeafID(curNodeIDs[lane]);
+					activeMask &= ~laneBit;
+				}
+				else
+				{
+					check(curNodeIDs[lane] < Nodes.Num());
+				}
+			}
+		}
+	}
+}
+
+/** Gets whether the position is within the bounding planes of the leaf. */
+bool AVBSPInfo::IsInLeaf(const FVector3f& pos, const int leafIndex) const
+{
+	if (!Leaves.IsValidIndex(leafIndex)) { return false; }
+	const FVBSPRange& range = Leaves[leafIndex].Planes;
+	if (range.Count <= 0 || range.Offset < 0) { return false; }
+	check(range.Offset + range.Count <= LeafPlanePool.Num());
+	const VectorRegister4Float posVec = MakeVectorRegisterFloat(pos.X, pos.Y, pos.Z, -1.0f);
+	const FPlane4f* planes = LeafPlanePool.GetData() + range.Offset;
+	for (int32 i = 0; i < range.Count; ++i)
+	{
+		// X*x + Y*y + Z*z - W
+		const VectorRegister4Float dist = VectorDot4(VectorLoad(&planes[i].X), posVec);
+		if (VectorGetComponent(dist, 0) < 0.0f) { return false; }
+	}
+	return true;
+}
+
 /** Gets the cluster that contains the position, or -1 if the position is not inside a cluster. */
 int AVBSPInfo::FindCluster(const FVector3f& pos) const
 {
@@ -31,6 +142,50 @@ int AVBSPInfo::FindCluster(const FVector3f& pos) const
 	return leaf.Cluster;
 }
 
+/** Calls the function with every leaf that the box touches, walking down both sides of only the planes that the box straddles. */
+template <typename TFunc>
+static void ForEachLeafInBox(TArrayView<const FVBSPNode> nodes, const FBox3f& box, TFunc&& func)
+{
+	if (nodes.Num() == 0) { return; }
+	const FVector3f center = box.GetCenter();
+	const FVector3f extents = box.GetExtent();
+	TArray<int32, TInlineAllocator<32>> stack;
+	stack.Add(0);
+	while (stack.Num() > 0)
+	{
+		const int32 nodeID = stack.Pop(false);
+		if (nodeID < 0)
+		{
+			func(-(1 + nodeID));
+			continue;
+		}
+		check(nodeID < nodes.Num());
+		const FVBSPNode& node = nodes[nodeID];
+		const float dist = node.Plane.PlaneDot(center);
+		const float offset = FMath::Abs(node.Plane.X) * extents.X + FMath::Abs(node.Plane.Y) * extents.Y + FMath::Abs(node.Plane.Z) * extents.Z;
+		if (dist >= -offset) { stack.Add(node.Front); }
+		if (dist < offset) { stack.Add(node.Back); }
+	}
+}
+
+/** Finds all leaves that the box touches. Leaves shared between nodes may be listed more than once. */
+void AVBSPInfo::FindLeavesInBox(const FBox3f& box, TArray<int32>& outLeaves) const
+{
+	outLeaves.Reset();
+	ForEachLeafInBox(Nodes, box, [&](int32 leafIndex) { outLeaves.Add(leafIndex); });
+}
+
+/** Finds all clusters that have a leaf touching the box, in no particular order. Nothing is found if the box only touches solid leaves or the void. */
+void AVBSPInfo::FindClustersInBox(const FBox3f& box, TArray<int32>& outClusters) const
+{
+	outClusters.Reset();
+	ForEachLeafInBox(Nodes, box, [&](int32 leafIndex)
+		{
+			const int32 cluster = Leaves[leafIndex].Cluster;
+			if (cluster >= 0) { outClusters.AddUnique(cluster); }
+		});
+}
+
 /** Finds all clusters that are reachable from the specified one. */
 void AVBSPInfo::FindReachableClusters(const int baseCluster, TSet<int>& out) const
 {
@@ -42,8 +197,7 @@ void AVBSPInfo::FindReachableClusters(const int baseCluster, TSet<int>& out) con
 	{
 		const int clusterID = clusterStack.Pop();
 		check(clusterID >= 0 && clusterID < Clusters.Num());
-		const FVBSPCluster& cluster = Clusters[clusterID];
-		for (const int otherClusterID : cluster.VisibleClusters)
+		for (const int otherClusterID : GetClusterVisibility(clusterID))
 		{
 			bool alreadyInSet;
 			out.Add(otherClusterID, &alreadyInSet);
@@ -55,36 +209,356 @@ void AVBSPInfo::FindReachableClusters(const int baseCluster, TSet<int>& out) con
 	}
 }
 
-/** Finds all entities that are contained within the cluster. Only checks origin point of entity, not entire bounds. */
+/** Finds all cells that intersect the cluster. */
+void AVBSPInfo::FindCellsInCluster(const int clusterIndex, TArray<AStaticMeshActor*>& out) const
+{
+	if (!Clusters.IsValidIndex(clusterIndex)) { return; }
+	for (AActor* actor : GetActorRange(Clusters[clusterIndex].Cells))
+	{
+		if (actor != nullptr) { out.Add(CastChecked<AStaticMeshActor>(actor)); }
+	}
+}
+
+/** Finds all entities that are contained within the cluster. Only checks origin point of entity at import time, not entire bounds. */
 void AVBSPInfo::FindEntitiesInCluster(const int clusterIndex, TSet<ABaseEntity*>& out) const
 {
-	// Iterate all entities
-	for (TActorIterator<ABaseEntity> it(GetWorld()); it; ++it)
+	if (!Clusters.IsValidIndex(clusterIndex)) { return; }
+	for (AActor* actor : GetActorRange(Clusters[clusterIndex].Entities))
 	{
-		ABaseEntity* entity = *it;
-		if (FindCluster(FVector3f(entity->GetRootComponent()->GetComponentLocation())) == clusterIndex)
+		// Entities may have been destroyed since the index was built
+		if (IsValid(actor)) { out.Add(CastChecked<ABaseEntity>(actor)); }
+	}
+}
+
+/** Finds all entities that are contained within one of the clusters. Only checks origin point of entity at import time, not entire bounds. */
+void AVBSPInfo::FindEntitiesInClusters(const TSet<int>& clusterIndices, TSet<ABaseEntity*>& out) const
+{
+	for (const int clusterIndex : clusterIndices)
+	{
+		FindEntitiesInCluster(clusterIndex, out);
+	}
+}
+
+TArrayView<const int32> AVBSPInfo::GetClusterLeaves(const int clusterIndex) const
+{
+	if (!Clusters.IsValidIndex(clusterIndex)) { return TArrayView<const int32>(); }
+	const FVBSPRange& range = Clusters[clusterIndex].Leaves;
+	return TArrayView<const int32>(LeafPool.GetData() + range.Offset, range.Count);
+}
+
+TArrayView<const int32> AVBSPInfo::GetClusterVisibility(const int clusterIndex) const
+{
+	if (!Clusters.IsValidIndex(clusterIndex)) { return TArrayView<const int32>(); }
+	const FVBSPRange& range = Clusters[clusterIndex].VisibleClusters;
+	return TArrayView<const int32>(VisibilityPool.GetData() + range.Offset, range.Count);
+}
+
+/**
+ * Sweeps an axis-aligned box with the given half extents from start to end against every world brush whose contents match the mask.
+ * Follows the clip hull rules of Source, so the box stops a small epsilon short of the surface and slides along bevelled edges.
+ * Traces do not allocate and give the same result for the same inputs.
+ */
+FVBSPTraceResult AVBSPInfo::TraceBox(const FVector3f& start, const FVector3f& end, const FVector3f& extents, int32 contentsMask) const
+{
+	FTraceWork work;
+	work.Start = start;
+	work.End = end;
+	work.Extents = extents.GetAbs();
+	work.ContentsMask = contentsMask;
+	work.IsRay = work.Extents.IsNearlyZero();
+	if (Nodes.Num() > 0 && Brushes.Num() > 0)
+	{
+		TraceNode(work, 0, 0.0f, 1.0f, start, end);
+	}
+	FVBSPTraceResult& result = work.Result;
+	result.EndPos = result.Fraction >= 1.0f ? end : start + (end - start) * result.Fraction;
+	return result;
+}
+
+/** Traces a ray from start to end against every world brush whose contents match the mask. Bevel sides are ignored. */
+FVBSPTraceResult AVBSPInfo::TraceRay(const FVector3f& start, const FVector3f& end, int32 contentsMask) const
+{
+	return TraceBox(start, end, FVector3f::ZeroVector, contentsMask);
+}
+
+void AVBSPInfo::TraceNode(FTraceWork& work, int32 nodeID, float startFraction, float endFraction, const FVector3f& start, const FVector3f& end) const
+{
+	// Already hit something nearer than this segment
+	if (work.Result.Fraction <= startFraction) { return; }
+	if (nodeID < 0)
+	{
+		TraceLeaf(work, NodeIDToLeafID(nodeID));
+		return;
+	}
+
+	const FVBSPNode& node = Nodes[nodeID];
+	const FVector3f normal(node.Plane);
+	const float startDist = node.Plane.PlaneDot(start);
+	const float endDist = node.Plane.PlaneDot(end);
+	const float offset = work.IsRay ? 0.0f : FMath::Abs(normal.X) * work.Extents.X + FMath::Abs(normal.Y) * work.Extents.Y + FMath::Abs(normal.Z) * work.Extents.Z;
+
+	// Entirely on one side, so only that child can be hit
+	if (startDist >= offset && endDist >= offset)
+	{
+		TraceNode(work, node.Front, startFraction, endFraction, start, end);
+		return;
+	}
+	if (startDist < -offset && endDist < -offset)
+	{
+		TraceNode(work, node.Back, startFraction, endFraction, start, end);
+		return;
+	}
+
+	// Split the segment where the hull crosses the plane, overlapping the halves by the epsilon so that neither misses a brush on the plane
+	bool nearIsBack;
+	float nearFraction, farFraction;
+	if (startDist < endDist)
+	{
+		const float invDist = 1.0f / (startDist - endDist);
+		nearIsBack = true;
+		nearFraction = (startDist - offset + TraceDistEpsilon) * invDist;
+		farFraction = (startDist + offset + TraceDistEpsilon) * invDist;
+	}
+	else if (startDist > endDist)
+	{
+		const float invDist = 1.0f / (startDist - endDist);
+		nearIsBack = false;
+		nearFraction = (startDist + offset + TraceDistEpsilon) * invDist;
+		farFraction = (startDist - offset - TraceDistEpsilon) * invDist;
+	}
+	else
+	{
+		nearIsBack = false;
+		nearFraction = 1.0f;
+		farFraction = 0.0f;
+	}
+	nearFraction = FMath::Clamp(nearFraction, 0.0f, 1.0f);
+	farFraction = FMath::Clamp(farFraction, 0.0f, 1.0f);
+
+	const float nearMidFraction = startFraction + (endFraction - startFraction) * nearFraction;
+	const FVector3f nearMid = start + (end - start) * nearFraction;
+	TraceNode(work, nearIsBack ? node.Back : node.Front, startFraction, nearMidFraction, start, nearMid);
+
+	const float farMidFraction = startFraction + (endFraction - startFraction) * farFraction;
+	const FVector3f farMid = start + (end - start) * farFraction;
+	TraceNode(work, nearIsBack ? node.Front : node.Back, farMidFraction, endFraction, farMid, end);
+}
+
+void AVBSPInfo::TraceLeaf(FTraceWork& work, int32 leafID) const
+{
+	if (!Leaves.IsValidIndex(leafID)) { return; }
+	const FVBSPRange& range = Leaves[leafID].Brushes;
+	check(range.Offset + range.Count <= LeafBrushPool.Num());
+	for (int32 i = 0; i < range.Count; ++i)
+	{
+		// Brushes shared between leaves are clipped again, which is harmless as clipping only ever shortens the trace
+		const int32 brushIndex = LeafBrushPool[range.Offset + i];
+		if (!(Brushes[brushIndex].Contents & work.ContentsMask)) { continue; }
+		ClipToBrush(work, brushIndex);
+		if (work.Result.AllSolid) { return; }
+	}
+}
+
+void AVBSPInfo::ClipToBrush(FTraceWork& work, int32 brushIndex) const
+{
+	const FVBSPBrush& brush = Brushes[brushIndex];
+	if (brush.Sides.Count <= 0) { return; }
+	check(brush.Sides.Offset + brush.Sides.Count <= BrushSides.Num());
+
+	float enterFraction = -1.0f;
+	float leaveFraction = 1.0f;
+	const FVBSPBrushSide* enterSide = nullptr;
+	bool startsOut = false;
+	bool endsOut = false;
+	const FVBSPBrushSide* sides = BrushSides.GetData() + brush.Sides.Offset;
+	for (int32 i = 0; i < brush.Sides.Count; ++i)
+	{
+		const FVBSPBrushSide& side = sides[i];
+		if (side.Bevel && work.IsRay) { continue; }
+
+		// Push the plane out by the hull so that the box can be treated as a point
+		const FVector3f normal(side.Plane);
+		const float offset = work.IsRay ? 0.0f : FMath::Abs(normal.X) * work.Extents.X + FMath::Abs(normal.Y) * work.Extents.Y + FMath::Abs(normal.Z) * work.Extents.Z;
+		const float startDist = side.Plane.PlaneDot(work.Start) - offset;
+		const float endDist = side.Plane.PlaneDot(work.End) - offset;
+		if (startDist > 0.0f) { startsOut = true; }
+		if (endDist > 0.0f) { endsOut = true; }
+
+		// Entirely in front of this side, so the brush can't be hit
+		if (startDist > 0.0f && endDist >= startDist) { return; }
+
+		// Entirely behind this side, so it doesn't limit the trace
+		if (startDist <= 0.0f && endDist <= 0.0f) { continue; }
+
+		if (startDist > endDist)
 		{
-			out.Add(entity);
+			const float fraction = (startDist - TraceDistEpsilon) / (startDist - endDist);
+			if (fraction > enterFraction)
+			{
+				enterFraction = fraction;
+				enterSide = &side;
+			}
+		}
+		else
+		{
+			const float fraction = (startDist + TraceDistEpsilon) / (startDist - endDist);
+			leaveFraction = FMath::Min(leaveFraction, fraction);
 		}
 	}
+
+	FVBSPTraceResult& result = work.Result;
+	if (!startsOut)
+	{
+		result.StartSolid = true;
+		result.Contents = brush.Contents;
+		result.Brush = brushIndex;
+		if (!endsOut)
+		{
+			result.AllSolid = true;
+			result.Fraction = 0.0f;
+		}
+		return;
+	}
+	if (enterSide != nullptr && enterFraction < leaveFraction && enterFraction < result.Fraction)
+	{
+		result.Fraction = FMath::Max(enterFraction, 0.0f);
+		result.Normal = FVector3f(enterSide->Plane);
+		result.Contents = brush.Contents;
+		result.Brush = brushIndex;
+	}
 }
 
-/** Finds all entities that are contained within one of the clusters. Only checks origin point of entity, not entire bounds. */
-void AVBSPInfo::FindEntitiesInClusters(const TSet<int>& clusterIndices, TSet<ABaseEntity*>& out) const
+#if WITH_EDITOR
+
+void AVBSPInfo::SetClusterActors(const TArray<TArray<AStaticMeshActor*>>& cellsByCluster, const TArray<TArray<ABaseEntity*>>& entitiesByCluster)
 {
-	// Iterate all entities
+	int totalCount = 0;
+	for (const TArray<AStaticMeshActor*>& cells : cellsByCluster) { totalCount += cells.Num(); }
+	for (const TArray<ABaseEntity*>& entities : entitiesByCluster) { totalCount += entities.Num(); }
+	ActorPool.Empty(totalCount);
+
+	// Keep each cluster's cells and entities adjacent so a cluster's actors are contiguous in memory
+	for (int clusterIndex = 0; clusterIndex < Clusters.Num(); ++clusterIndex)
+	{
+		FVBSPCluster& cluster = Clusters[clusterIndex];
+		cluster.Cells.Offset = ActorPool.Num();
+		if (cellsByCluster.IsValidIndex(clusterIndex))
+		{
+			ActorPool.Append(cellsByCluster[clusterIndex]);
+		}
+		cluster.Cells.Count = ActorPool.Num() - cluster.Cells.Offset;
+		cluster.Entities.Offset = ActorPool.Num();
+		if (entitiesByCluster.IsValidIndex(clusterIndex))
+		{
+			ActorPool.Append(entitiesByCluster[clusterIndex]);
+		}
+		cluster.Entities.Count = ActorPool.Num() - cluster.Entities.Offset;
+	}
+}
+
+void AVBSPInfo::RebuildEntityIndex()
+{
+	TArray<TArray<AStaticMeshActor*>> cellsByCluster;
+	TArray<TArray<ABaseEntity*>> entitiesByCluster;
+	cellsByCluster.SetNum(Clusters.Num());
+	entitiesByCluster.SetNum(Clusters.Num());
+	for (int clusterIndex = 0; clusterIndex < Clusters.Num(); ++clusterIndex)
+	{
+		FindCellsInCluster(clusterIndex, cellsByCluster[clusterIndex]);
+	}
 	for (TActorIterator<ABaseEntity> it(GetWorld()); it; ++it)
 	{
 		ABaseEntity* entity = *it;
-		if (clusterIndices.Contains(FindCluster(FVector3f(entity->GetRootComponent()->GetComponentLocation()))))
+		if (entity->GetRootComponent() == nullptr) { continue; }
+		const int clusterIndex = FindCluster(FVector3f(entity->GetRootComponent()->GetComponentLocation()));
+		if (!entitiesByCluster.IsValidIndex(clusterIndex)) { continue; }
+		entitiesByCluster[clusterIndex].Add(entity);
+	}
+	SetClusterActors(cellsByCluster, entitiesByCluster);
+}
+
+void AVBSPInfo::BuildLeafBoundingPlanes()
+{
+	LeafPlanePool.Empty();
+	for (FVBSPLeaf& leaf : Leaves) { leaf.Planes = FVBSPRange(); }
+	if (Nodes.Num() == 0) { return; }
+
+	// Gather the half-spaces along the path to every leaf, oriented so that the leaf is in front of each
+	TArray<TArray<FPlane4f>> leafHalfSpaces;
+	TBitArray<> leafReachedTwice(false, Leaves.Num());
+	leafHalfSpaces.SetNum(Leaves.Num());
+	{
+		struct ExploreState
 		{
-			out.Add(entity);
+			int32 NodeID;
+			int32 Depth;
+			FPlane4f HalfSpace;
+		};
+		TArray<FPlane4f> path;
+		TArray<ExploreState> exploreStack;
+		exploreStack.Push({ 0, 0, FPlane4f() });
+		while (exploreStack.Num() > 0)
+		{
+			const ExploreState state = exploreStack.Pop(false);
+			path.SetNum(state.Depth, false);
+			if (state.Depth > 0) { path[state.Depth - 1] = state.HalfSpace; }
+			if (state.NodeID < 0)
+			{
+				const int32 leafID = NodeIDToLeafID(state.NodeID);
+				if (!Leaves.IsValidIndex(leafID)) { continue; }
+				if (leafHalfSpaces[leafID].Num() > 0) { leafReachedTwice[leafID] = true; }
+				leafHalfSpaces[leafID] = path;
+				continue;
+			}
+			const FVBSPNode& node = Nodes[state.NodeID];
+			exploreStack.Push({ node.Front, state.Depth + 1, node.Plane });
+			exploreStack.Push({ node.Back, state.Depth + 1, node.Plane.Flip() });
 		}
 	}
+
+	// Discard any half-space that does not contribute a face to the leaf volume
+	TArray<TArray<FPlane4f>> leafBoundingPlanes;
+	leafBoundingPlanes.SetNum(Leaves.Num());
+	ParallelFor(Leaves.Num(), [&](int32 leafID)
+	{
+		if (leafReachedTwice[leafID]) { return; }
+		const TArray<FPlane4f>& halfSpaces = leafHalfSpaces[leafID];
+		for (int32 i = 0; i < halfSpaces.Num(); ++i)
+		{
+			FPoly poly = FPoly::BuildInfiniteFPoly((FPlane)halfSpaces[i]);
+			int32 numVerts = poly.Vertices.Num();
+			for (int32 j = 0; j < halfSpaces.Num() && numVerts >= 3; ++j)
+			{
+				if (j == i) { continue; }
+				const FVector3f normal(halfSpaces[j]);
+				numVerts = poly.Split(normal, normal * halfSpaces[j].W);
+			}
+			if (numVerts >= 3)
+			{
+				leafBoundingPlanes[leafID].Add(halfSpaces[i]);
+			}
+		}
+	});
+
+	// Pack into the pool
+	for (int32 leafID = 0; leafID < Leaves.Num(); ++leafID)
+	{
+		FVBSPRange& range = Leaves[leafID].Planes;
+		range.Offset = LeafPlanePool.Num();
+		range.Count = leafBoundingPlanes[leafID].Num();
+		LeafPlanePool.Append(leafBoundingPlanes[leafID]);
+	}
 }
 
+#endif
+
 int AVBSPInfo::NodeIDToLeafID(int nodeID) const
 {
 	if (nodeID >= 0) { return -1; }
 	return -(nodeID + 1);
-}
\ No newline at end of file
+}
+
+TArrayView<AActor* const> AVBSPInfo::GetActorRange(const FVBSPRange& range) const
+{
+	return TArrayView<AActor* const>(ActorPool.GetData() + range.Offset, range.Count);
+}
@@ -0,0 +1,110 @@
+#include "HL2RuntimePrivatePCH.h"
+
+#include "Misc/AutomationTest.h"
+#include "VBSPInfo.h"
+
+BEGIN_DEFINE_SPEC(VBSPInfoSpec, "HL2.VBSPInfo.Spec", EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+AVBSPInfo* Info;
+FVector3f Extents = FVector3f(10.0f, 10.0f, 10.0f);
+void MakeSingleBrushWorld();
+END_DEFINE_SPEC(VBSPInfoSpec)
+
+/** Builds a world split at z = 0, with empty space above and a single solid box brush from (-100, -100, -100) to (100, 100, 0) below. */
+void VBSPInfoSpec::MakeSingleBrushWorld()
+{
+	Info = NewObject<AVBSPInfo>(GetTransientPackage());
+
+	FVBSPNode& node = Info->Nodes.AddDefaulted_GetRef();
+	node.Plane = FPlane4f(FVector3f(0.0f, 0.0f, 1.0f), 0.0f);
+	node.Front = -1;
+	node.Back = -2;
+
+	Info->Leaves.AddDefaulted();
+	FVBSPLeaf& solidLeaf = Info->Leaves.AddDefaulted_GetRef();
+	solidLeaf.Solid = true;
+	solidLeaf.Brushes.Offset = 0;
+	solidLeaf.Brushes.Count = 1;
+	Info->LeafBrushPool.Add(0);
+
+	FVBSPBrush& brush = Info->Brushes.AddDefaulted_GetRef();
+	brush.Contents = EVBSPContents::Solid;
+	brush.Sides.Offset = 0;
+	brush.Sides.Count = 6;
+	const FPlane4f planes[] =
+	{
+		FPlane4f(FVector3f(0.0f, 0.0f, 1.0f), 0.0f),
+		FPlane4f(FVector3f(0.0f, 0.0f, -1.0f), 100.0f),
+		FPlane4f(FVector3f(1.0f, 0.0f, 0.0f), 100.0f),
+		FPlane4f(FVector3f(-1.0f, 0.0f, 0.0f), 100.0f),
+		FPlane4f(FVector3f(0.0f, 1.0f, 0.0f), 100.0f),
+		FPlane4f(FVector3f(0.0f, -1.0f, 0.0f), 100.0f),
+	};
+	for (const FPlane4f& plane : planes)
+	{
+		Info->BrushSides.AddDefaulted_GetRef().Plane = plane;
+	}
+}
+
+void VBSPInfoSpec::Define()
+{
+	Describe("AVBSPInfo", [this]()
+		{
+			BeforeEach([this]()
+				{
+					MakeSingleBrushWorld();
+				});
+
+			AfterEach([this]()
+				{
+					Info->MarkAsGarbage();
+					Info = nullptr;
+				});
+
+			Describe("TraceBox", [this]()
+				{
+					It("will stop a box short of the brush it hits", [this]()
+						{
+							const FVBSPTraceResult trace = Info->TraceBox(FVector3f(0.0f, 0.0f, 50.0f), FVector3f(0.0f, 0.0f, -50.0f), Extents);
+							TestFalse("StartSolid", trace.StartSolid);
+							TestEqual("Brush", trace.Brush, 0);
+							TestTrue("Fraction", trace.Fraction > 0.39f && trace.Fraction < 0.4f);
+							TestEqual("Normal", trace.Normal, FVector3f(0.0f, 0.0f, 1.0f));
+						});
+
+					It("will report a box starting inside a brush and staying inside as all solid", [this]()
+						{
+							const FVBSPTraceResult trace = Info->TraceBox(FVector3f(0.0f, 0.0f, 5.0f), FVector3f(20.0f, 0.0f, 5.0f), Extents);
+							TestTrue("StartSolid", trace.StartSolid);
+							TestTrue("AllSolid", trace.AllSolid);
+							TestEqual("Fraction", trace.Fraction, 0.0f);
+						});
+
+					It("will let a box starting inside a brush move out of it", [this]()
+						{
+							const FVector3f end(0.0f, 0.0f, 50.0f);
+							const FVBSPTraceResult trace = Info->TraceBox(FVector3f(0.0f, 0.0f, 5.0f), end, Extents);
+							TestTrue("StartSolid", trace.StartSolid);
+							TestFalse("AllSolid", trace.AllSolid);
+							TestEqual("Fraction", trace.Fraction, 1.0f);
+
+							const FVBSPTraceResult endTrace = Info->TraceBox(end, end, Extents);
+							TestFalse("end StartSolid", endTrace.StartSolid);
+						});
+
+					It("will report a box resting inside a brush as all solid", [this]()
+						{
+							const FVector3f pos(0.0f, 0.0f, 5.0f);
+							const FVBSPTraceResult trace = Info->TraceBox(pos, pos, Extents);
+							TestTrue("StartSolid", trace.StartSolid);
+							TestTrue("AllSolid", trace.AllSolid);
+						});
+
+					It("will ignore brushes whose contents are not in the mask", [this]()
+						{
+							const FVBSPTraceResult trace = Info->TraceBox(FVector3f(0.0f, 0.0f, 5.0f), FVector3f(20.0f, 0.0f, 5.0f), Extents, EVBSPContents::PlayerClip);
+							TestFalse("StartSolid", trace.StartSolid);
+							TestEqual("Fraction", trace.Fraction, 1.0f);
+						});
+				});
+		});
+}
@@ -4,6 +4,8 @@
 #include "EditorFramework/AssetImportData.h"
 #endif
 
+const FName UVMTMaterial::TexturesTagName(TEXT("HL2Textures"));
+
 void UVMTMaterial::PostInitProperties()
 {
 #if WITH_EDITORONLY_DATA
@@ -15,16 +17,29 @@ void UVMTMaterial::PostInitProperties()
 	Super::PostInitProperties();
 }
 
-#if WITH_EDITORONLY_DATA
 void UVMTMaterial::GetAssetRegistryTags(TArray<FAssetRegistryTag>& OutTags) const
 {
+#if WITH_EDITORONLY_DATA
 	if (AssetImportData)
 	{
 		OutTags.Add(FAssetRegistryTag(SourceFileTagName(), AssetImportData->GetSourceData().ToJson(), FAssetRegistryTag::TT_Hidden));
 	}
+#endif
+
+	// Always written, even when empty, so that a missing tag means the material predates it
+	TStringBuilder<256> textures;
+	for (const auto& pair : vmtTextures)
+	{
+		if (pair.Value.IsNone()) { continue; }
+		if (textures.Len() > 0) { textures << TEXT(';'); }
+		textures << pair.Value;
+	}
+	OutTags.Add(FAssetRegistryTag(TexturesTagName, textures.ToString(), FAssetRegistryTag::TT_Hidden));
 
 	Super::GetAssetRegistryTags(OutTags);
 }
+
+#if WITH_EDITORONLY_DATA
 void UVMTMaterial::Serialize(FArchive& Ar)
 {
 	Super::Serialize(Ar);
@@ -44,4 +59,15 @@ bool UVMTMaterial::DoesReferenceTexture(FName assetPath) const
 		if (pair.Value == assetPath) { return true; }
 	}
 	return false;
+}
+
+void UVMTMaterial::ParseTexturesTag(const FString& tagValue, TArray<FName>& outTextures)
+{
+	TArray<FString> textures;
+	tagValue.ParseIntoArray(textures, TEXT(";"));
+	outTextures.Reserve(outTextures.Num() + textures.Num());
+	for (const FString& texture : textures)
+	{
+		outTextures.AddUnique(FName(*texture));
+	}
 }
\ No newline at end of file
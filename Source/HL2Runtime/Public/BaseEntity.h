@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "HL2EntityData.h"
+#include "HL2PVSTickSubsystem.h"
 
 #include "BaseEntity.generated.h"
 
@@ -15,32 +16,12 @@ class AVBSPInfo;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogHL2IOSystem, Log, All);
 
-USTRUCT()
-struct FPendingFireOutput
-{
-	GENERATED_BODY()
-
-public:
-
-	UPROPERTY()
-	FEntityLogicOutput Output;
-
-	UPROPERTY()
-	ABaseEntity* Caller;
-
-	UPROPERTY()
-	ABaseEntity* Activator;
-
-	UPROPERTY()
-	TArray<FString> Args;
-
-	UPROPERTY()
-	FTimerHandle TimerHandle;
-};
-
 UCLASS()
 class HL2RUNTIME_API ABaseEntity : public AActor
 {
+	friend class UHL2EventQueueSubsystem;
+	friend class UBaseEntityComponent;
+
 	GENERATED_BODY()
 	
 public:
@@ -61,14 +42,40 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	AVBSPInfo* VBSPInfo;
 
+	/** How entities of this class tick while no local player can see them. Logic entities that must always run should use AlwaysTick. Read every frame, so it may be changed at any time. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "HL2")
+	EHL2PVSTickPolicy PVSTickPolicy = EHL2PVSTickPolicy::Throttle;
+
 protected:
 
 	/** All current logic outputs, valid or not, on this entity. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	TArray<FEntityLogicOutput> LogicOutputs;
 
-	UPROPERTY()
-	TArray<FTimerHandle> PendingOutputs;
+	/** A natively handled input. Returns true if the input was successfully handled. */
+	using FInputHandler = bool (ABaseEntity::*)(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	/** A natively handled input, and whether components and blueprints still hear about the input once it has been handled. */
+	struct FNativeInputHandler
+	{
+		FInputHandler Handler;
+		bool PassThrough;
+
+		FNativeInputHandler(FInputHandler handler, bool passThrough = false) : Handler(handler), PassThrough(passThrough) {}
+	};
+
+private:
+
+	/** How inputs are dispatched for one entity class, built once per class. */
+	struct FInputDispatchTable
+	{
+		TMap<FName, FNativeInputHandler> NativeHandlers;
+		bool CallOnInputFired = false;
+	};
+
+	/** Components that want to hear about inputs, maintained as they register and unregister. */
+	UPROPERTY(Transient)
+	TArray<UBaseEntityComponent*> InputComponents;
 
 public:
 
@@ -76,6 +83,24 @@ public:
 
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type endPlayReason) override;
+
+	virtual void PostRegisterAllComponents() override;
+
+	virtual void PostUnregisterAllComponents() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& propertyChangedEvent) override;
+
+	virtual void PostEditChangeChainProperty(FPropertyChangedChainEvent& propertyChangedEvent) override;
+#endif
+
+	/**
+	 * Changes the targetname of this entity, keeping the world's targetname index up to date.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "HL2")
+	void SetTargetName(const FName newTargetName);
+
 	/**
 	 * Fires a logic input on this entity.
 	 * Returns true if the logic input was successfully handled.
@@ -108,8 +133,30 @@ public:
 
 protected:
 
-	UFUNCTION()
-	void FireOutputInternal(const FPendingFireOutput& data);
+	/**
+	 * Adds the inputs this class handles natively to the map. Called once per native class, on the class default object.
+	 * Derived classes must call Super so that the basic inputs remain handled.
+	 * Inputs that only some entities act on in Source, such as CancelPending, are passed through so that components and blueprints can still handle them.
+	 */
+	virtual void RegisterInputHandlers(TMap<FName, FNativeInputHandler>& handlers) const;
+
+	bool InputKill(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	bool InputAddOutput(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	bool InputCancelPending(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	bool InputFireUser1(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	bool InputFireUser2(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	bool InputFireUser3(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	bool InputFireUser4(const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	void FireOutputInternal(const FName targetName, const FName inputName, const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+	void FireInputOnTargets(TArrayView<ABaseEntity* const> targets, const FName inputName, const TArray<FString>& args, ABaseEntity* caller);
 
 	/**
 	 * Published when an input has been fired on this entity.
@@ -119,4 +166,8 @@ protected:
 
 	void OnInputFired_Implementation(const FName inputName, const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
 
+private:
+
+	static const FInputDispatchTable& GetInputDispatchTable(const UClass* entityClass);
+
 };
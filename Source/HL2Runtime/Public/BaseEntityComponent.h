@@ -29,6 +29,10 @@ public:
 
 	virtual void BeginPlay() override;
 
+	virtual void OnRegister() override;
+
+	virtual void OnUnregister() override;
+
 	/**
 	 * Fires a logic output on the owner entity.
 	 * Returns the number of entities that succesfully handled the output.
@@ -45,5 +49,10 @@ protected:
 	void OnInputFired(const FName inputName, const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
 
 	void OnInputFired_Implementation(const FName inputName, const TArray<FString>& args, ABaseEntity* caller, ABaseEntity* activator);
+
+private:
+
+	/** Gets whether components of the class do anything with inputs, cached per class. */
+	static bool HandlesInputs(const UClass* componentClass);
 		
 };
@@ -4,14 +4,62 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "VBSPInfo.h"
 #include "HL2CharacterMovementComponent.generated.h"
 
 /**
- * 
+ * Character movement that collides with the world brushes of the map through the native vbsp hull traces of AVBSPInfo,
+ * so that players slide along the same clip hulls as in Source, including player clips that have no render geometry.
+ * While hull traces are in use the physics sweep ignores the brush geometry actors, so brushes are only traced once.
+ * The one exception is a move that starts and stays inside a brush, which the physics sweep handles with the brush geometry included.
+ * Everything else, including displacements, all other actors and maps without imported brushes, is still swept through the physics scene.
  */
 UCLASS()
 class HL2RUNTIME_API UHL2CharacterMovementComponent : public UCharacterMovementComponent
 {
 	GENERATED_BODY()
 	
+public:
+
+	/** Whether to sweep against the vbsp brushes of the map when moving and finding the floor. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HL2")
+	bool UseBSPHullTraces = true;
+
+	/** The brush contents that block this character, see EVBSPContents. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HL2")
+	int32 BSPContentsMask = EVBSPContents::MaskPlayerSolid;
+
+private:
+
+	TWeakObjectPtr<AVBSPInfo> vbspInfo;
+
+	bool ignoringBrushGeometry = false;
+
+public:
+
+	virtual void BeginPlay() override;
+
+	virtual void ComputeFloorDist(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult = NULL) const override;
+
+protected:
+
+	virtual bool MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit = NULL, ETeleportType Teleport = ETeleportType::None) override;
+
+private:
+
+	/** Gets the vbsp info to trace against, or null if hull traces should not be used. */
+	const AVBSPInfo* GetHullTraceInfo() const;
+
+	/** Makes the physics sweep ignore the brush geometry actors while hull traces are in use, and stop ignoring them otherwise. */
+	void UpdateIgnoredBrushGeometry();
+
+	/** Sets whether the physics sweep ignores the brush geometry actors. */
+	void SetBrushGeometryIgnored(bool ignore);
+
+	/** Gets the half extents of the box used for hull traces. */
+	FVector3f GetHullExtents() const;
+
+	/** Converts a hull trace into a blocking hit. */
+	static FHitResult MakeHitResult(const FVBSPTraceResult& trace, const FVector3f& start, const FVector3f& end, const FVector3f& extents);
+
 };
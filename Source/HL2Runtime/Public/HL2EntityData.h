@@ -1,9 +1,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Misc/TVariant.h"
 
 #include "HL2EntityData.generated.h"
 
+class ABaseEntity;
+
+/** A keyvalue parsed into the type it was last requested as through the typed accessors of FHL2EntityData. */
+using FHL2EntityTypedValue = TVariant<int32, bool, float, FVector3f, FVector4f>;
+
 USTRUCT(BlueprintType)
 struct HL2RUNTIME_API FEntityLogicOutput
 {
@@ -34,6 +40,15 @@ public:
 	// Parameters.
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	TArray<FString> Params;
+
+	// The entities the targetname was resolved to at import time. Only used when TargetsResolved is set.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<TSoftObjectPtr<ABaseEntity>> ResolvedTargets;
+
+	// Whether ResolvedTargets held every target at import time, so the targetname does not need resolving when fired.
+	// The targetname is still resolved if an entity has taken the name during play.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	bool TargetsResolved = false;
 };
 
 USTRUCT(BlueprintType)
@@ -62,8 +77,22 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	int SpawnFlags = 0;
 
+private:
+
+	// Typed values parsed from KeyValues on first typed access, so repeated accessors are a lookup and a copy. Not serialized.
+	mutable TMap<FName, FHL2EntityTypedValue> TypedValues;
+
 public:
 
+	/** Parses the keyvalues that most entities read into their typed form up front. */
+	void CacheCommonTypedValues() const;
+
+	/** Discards all typed values. Must be called after modifying KeyValues of an entity that has already been read from. */
+	void ResetTypedValues();
+
+	/** Discards the typed value of a single key. Must be called after modifying that keyvalue of an entity that has already been read from. */
+	void ResetTypedValue(FName key);
+
 	FString GetString(FName key) const;
 
 	bool TryGetString(FName key, FString& out) const;
@@ -88,4 +117,9 @@ public:
 
 	bool TryGetVector4(FName key, FVector4f& out) const;
 
+private:
+
+	template<typename T>
+	bool TryGetTyped(FName key, T& out, bool (*parse)(const FString&, T&)) const;
+
 };
\ No newline at end of file
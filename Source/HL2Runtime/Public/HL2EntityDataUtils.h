@@ -75,6 +75,10 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "HL2")
 	static FQuat ConvertSourceRotationToUnreal(const FQuat& rotation);
 
+	/** Converts Source pitch yaw roll angles, as found in the angles keyvalue and static props, to an unreal rotator. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "HL2")
+	static FRotator ConvertSourceAnglesToUnreal(const FVector& angles);
+
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "HL2")
 	static FTransform ConvertSourceTransformToUnreal(const FTransform& transform);
 	
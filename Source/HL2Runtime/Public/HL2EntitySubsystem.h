@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "HL2EntitySubsystem.generated.h"
+
+class ABaseEntity;
+
+/**
+ * Indexes all entities of a world by targetname and classname, so that IO target lookups do not have to scan every actor.
+ * Entities register themselves when their components are registered and unregister when they are destroyed or renamed.
+ */
+UCLASS()
+class HL2RUNTIME_API UHL2EntitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+private:
+
+	/** A node of the targetname prefix trie. Children are keyed by lower case character. */
+	struct FTargetNameTrieNode
+	{
+		TMap<TCHAR, int32> Children;
+		TArray<ABaseEntity*> Entities;
+	};
+
+	/** The names an entity is currently indexed under. */
+	struct FIndexedNames
+	{
+		FName TargetName;
+		FName Classname;
+	};
+
+	TMap<FName, TArray<ABaseEntity*>> entitiesByTargetName;
+	TMap<FName, TArray<ABaseEntity*>> entitiesByClassname;
+	TMap<ABaseEntity*, FIndexedNames> indexedEntities;
+
+	// Node 0 is the root
+	TArray<FTargetNameTrieNode> targetNameTrie;
+
+	// Names that an entity was indexed under after the world began play
+	TSet<FName> namesRegisteredDuringPlay;
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Adds the entity to the index, or re-indexes it if it is already present. */
+	void RegisterEntity(ABaseEntity* entity);
+
+	/** Removes the entity from the index. */
+	void UnregisterEntity(ABaseEntity* entity);
+
+	/**
+	 * Finds all entities whose targetname or classname matches.
+	 * A trailing "*" matches all targetnames that start with the preceding text and are longer than it.
+	 */
+	void FindEntitiesByTargetName(const FName targetName, TArray<ABaseEntity*>& outEntities) const;
+
+	/**
+	 * Gets whether any entity was indexed under the targetname or classname after the world began play, by spawning or renaming.
+	 * Targets resolved to the entities of the map at import time are incomplete for such names.
+	 */
+	bool HasEntitiesRegisteredDuringPlay(const FName name) const;
+
+private:
+
+	int32 FindTrieNode(FStringView prefix) const;
+
+	int32 FindOrAddTrieNode(const FString& prefix);
+
+	void CollectTrieEntities(int32 nodeIndex, TArray<ABaseEntity*>& outEntities) const;
+
+};
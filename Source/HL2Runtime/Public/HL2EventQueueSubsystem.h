@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "HL2EventQueueSubsystem.generated.h"
+
+class ABaseEntity;
+
+/**
+ * Holds all delayed entity IO events of a world in a single time ordered queue, serviced once per tick.
+ * Modelled on the event queue of the source engine, replacing a timer per delayed output.
+ */
+UCLASS()
+class HL2RUNTIME_API UHL2EventQueueSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+private:
+
+	struct FQueuedEvent
+	{
+		double FireTime = 0.0;
+		uint64 Serial = 0;
+		TWeakObjectPtr<ABaseEntity> Source;
+		FName TargetName;
+		TArray<TWeakObjectPtr<ABaseEntity>, TInlineAllocator<2>> Targets;
+		bool TargetsResolved = false;
+		FName InputName;
+		TArray<FString> Args;
+		TWeakObjectPtr<ABaseEntity> Caller;
+		TWeakObjectPtr<ABaseEntity> Activator;
+	};
+
+	/** Orders events by fire time, then by the order they were added in. */
+	struct FQueuedEventOrder
+	{
+		FORCEINLINE bool operator()(const FQueuedEvent& a, const FQueuedEvent& b) const
+		{
+			return a.FireTime < b.FireTime || (a.FireTime == b.FireTime && a.Serial < b.Serial);
+		}
+	};
+
+	// Binary heap, its storage is kept between ticks so queueing does not allocate in the steady state
+	TArray<FQueuedEvent> events;
+	uint64 nextSerial = 0;
+
+public:
+
+	virtual void Tick(float deltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Queues an output of the source entity to fire after the delay.
+	 * The target is resolved when the event fires, the source entity is passed to the input as its caller.
+	 */
+	void AddEvent(ABaseEntity* source, const FName targetName, const FName inputName, TArray<FString>&& args, float delay, ABaseEntity* caller, ABaseEntity* activator);
+
+	/** Queues an output of the source entity whose targets are already known to fire after the delay. */
+	void AddEvent(ABaseEntity* source, const FName targetName, TArrayView<ABaseEntity* const> targets, const FName inputName, TArray<FString>&& args, float delay, ABaseEntity* caller, ABaseEntity* activator);
+
+	/** Cancels all pending events fired by the source entity. Returns the number of events cancelled. */
+	int CancelEvents(const ABaseEntity* source);
+
+	/** Cancels all pending events targeting the entity by its targetname, optionally only those for one input. Returns the number of events cancelled. */
+	int CancelEventsOn(const ABaseEntity* target, const FName inputName = NAME_None);
+
+	/** Gets the number of events waiting to fire. */
+	FORCEINLINE int GetNumPendingEvents() const { return events.Num(); }
+
+};
@@ -46,6 +46,23 @@ public:
 
 };
 
+/** A static mesh baked from a single combination of bodygroups. */
+USTRUCT(BlueprintType)
+struct HL2RUNTIME_API FModelBodygroupVariant
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The model index chosen for each bodygroup, in the order of UHL2ModelData::BodygroupOrder. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<int> Combination;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	UStaticMesh* Mesh = nullptr;
+
+};
+
 UCLASS()
 class HL2RUNTIME_API UHL2ModelData : public UAssetUserData
 {
@@ -59,8 +76,25 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	TMap<FName, FModelBodygroup> Bodygroups;
 
+	/** The order of bodygroups within the combination of each baked variant. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<FName> BodygroupOrder;
+
+	/** Static meshes baked for each bodygroup combination. If present, bodygroups are applied to static meshes by swapping to these. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<FModelBodygroupVariant> BakedVariants;
+
 public:
 
+	/** Gets the bodygroup combination shown by the static mesh, or the default combination if it is not one of the baked variants. */
+	void GetStaticMeshBodygroups(const UStaticMesh* staticMesh, TArray<int>& outCombination) const;
+
+	/** Finds the baked variant for the bodygroup combination, or nullptr if it was not baked. */
+	UStaticMesh* FindBakedVariant(TArrayView<const int> combination) const;
+
+	/** Gets the mesh that should show in place of the static mesh by default, which is the default combination if the static mesh is the base mesh of baked variants. */
+	UStaticMesh* GetDefaultBakedVariant(UStaticMesh* staticMesh) const;
+
 	bool ApplyBodygroupToStaticMesh(UStaticMeshComponent* target, const FName bodygroupName, int index);
 
 	bool ApplySkinToStaticMesh(UStaticMeshComponent* target, int index);
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "HL2PVSTickSubsystem.generated.h"
+
+class ABaseEntity;
+class AVBSPInfo;
+class UActorComponent;
+struct FTickFunction;
+
+/** How an entity ticks while it is outside the potentially visible set of every local player. */
+UENUM(BlueprintType)
+enum class EHL2PVSTickPolicy : uint8
+{
+	/** Keeps ticking, at the interval set by hl2.PVSThrottleInterval. */
+	Throttle,
+	/** Stops ticking entirely until a player can see it again. */
+	Dormant,
+	/** Always ticks normally, for logic entities that must run wherever the player is, such as timers. */
+	AlwaysTick
+};
+
+/**
+ * Throttles the ticks of entities outside the potentially visible set of every local player, using the cluster visibility of the vbsp.
+ * Modelled on how the source engine keeps the think cost of the server bounded by the pvs.
+ * An entity is visible while any cluster touched by its bounds is, so large brush entities keep ticking while any part of them can be seen.
+ * Entities register themselves when play begins and unregister when play ends, whatever their policy, as the policy is read every frame.
+ * Ticks are restored as soon as an entity becomes visible again or switches to a different policy.
+ */
+UCLASS()
+class HL2RUNTIME_API UHL2PVSTickSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+private:
+
+	/**
+	 * The tick state of a function before it was throttled, and what throttling changed it to.
+	 * Only state that still holds what throttling set is restored, so changes made by the entity while throttled are kept.
+	 */
+	struct FSavedTick
+	{
+		float TickInterval = 0.0f;
+		float ThrottledInterval = 0.0f;
+		bool DisabledTick = false;
+	};
+
+	struct FSavedComponentTick
+	{
+		TWeakObjectPtr<UActorComponent> Component;
+		FSavedTick Tick;
+	};
+
+	struct FSavedEntityTick
+	{
+		EHL2PVSTickPolicy Policy = EHL2PVSTickPolicy::Throttle;
+		FSavedTick Tick;
+		TArray<FSavedComponentTick, TInlineAllocator<2>> Components;
+	};
+
+	// Registered entities, kept as parallel arrays
+	TArray<ABaseEntity*> entities;
+	TArray<FBox> entityBounds;
+	TArray<TArray<int32>> entityClusters;
+	TArray<double> entityLastVisibleTimes;
+	TArray<int32> entityThrottleSlots;
+	TMap<ABaseEntity*, int32> entityIndices;
+
+	// Saved tick state of throttled entities, slots are reused once an entity wakes up
+	TArray<FSavedEntityTick> throttleSlots;
+	TArray<int32> freeThrottleSlots;
+	int32 numThrottled = 0;
+
+	TWeakObjectPtr<AVBSPInfo> vbspInfo;
+	TBitArray<> visibleClusters;
+
+public:
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float deltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	/** Starts managing the ticks of the entity. Entities that currently always tick are registered too, so that they are managed if their policy changes. */
+	void RegisterEntity(ABaseEntity* entity);
+
+	/** Stops managing the ticks of the entity, restoring them if it was throttled. */
+	void UnregisterEntity(ABaseEntity* entity);
+
+	/** Gets the number of entities currently throttled or dormant. */
+	FORCEINLINE int GetNumThrottledEntities() const { return numThrottled; }
+
+private:
+
+	/** Gets how the entity ticks outside the pvs, as set on its class. */
+	static EHL2PVSTickPolicy GetTickPolicy(const ABaseEntity* entity);
+
+	/** Gets the bounds of the entity used to find the clusters it touches. */
+	static FBox GetEntityBounds(const ABaseEntity* entity);
+
+	/** Marks every cluster visible to a local player. Returns false if any local player is outside every cluster, in which case nothing should be throttled. */
+	bool GatherVisibleClusters(const AVBSPInfo& info);
+
+	void Throttle(int32 index, EHL2PVSTickPolicy policy);
+
+	void Wake(int32 index);
+
+	static void ThrottleTick(FTickFunction& tick, FSavedTick& saved, bool dormant, float throttleInterval);
+
+	static void WakeTick(FTickFunction& tick, const FSavedTick& saved);
+
+	void WakeAll();
+
+};
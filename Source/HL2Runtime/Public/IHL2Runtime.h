@@ -59,14 +59,27 @@ public:
 	virtual UMaterialInterface* TryResolveHL2Material(const FString& hl2TexturePath) const = 0;
 	virtual UStaticMesh* TryResolveHL2StaticProp(const FString& hl2ModelPath) const = 0;
 	virtual USkeletalMesh* TryResolveHL2AnimatedProp(const FString& hl2ModelPath) const = 0;
+
+	/** Resolves the static mesh imported alongside an animated model that can never visibly animate, or nullptr if there is none. */
+	virtual UStaticMesh* TryResolveHL2RigidProp(const FString& hl2ModelPath) const = 0;
 	virtual USoundWave* TryResolveHL2Sound(const FString& hl2SoundPath) const = 0;
 	virtual UObject* TryResolveHL2Script(const FString& hl2ScriptPath) const = 0;
 	virtual USurfaceProp* TryResolveHL2SurfaceProp(const FName& surfaceProp) const = 0;
 	virtual UMaterial* TryResolveHL2Shader(const FString& hl2ShaderPath, bool searchGameFirst = true) const = 0;
 
+	/** Resolves many asset paths at once, querying the asset registry a single time for all paths not already cached. outAssets is parallel to assetPaths. */
+	virtual void TryResolveAssets(TArrayView<const FName> assetPaths, TArray<UObject*>& outAssets) const = 0;
+	virtual void TryResolveHL2Materials(TArrayView<const FString> hl2MaterialPaths, TArray<UMaterialInterface*>& outMaterials) const = 0;
+
 	virtual void FindAllMaterialsThatReferenceTexture(const FString& hl2TexturePath, TArray<UMaterialInterface*>& out) const = 0;
 	virtual void FindAllMaterialsThatReferenceTexture(FName assetPath, TArray<UMaterialInterface*>& out) const = 0;
 
+	/** Finds the asset paths of all vmt materials that reference the texture, using the texture reference index. Does not load any material. */
+	virtual void FindAllMaterialPathsThatReferenceTexture(FName assetPath, TArray<FName>& outMaterialPaths) const = 0;
+
+	/** Updates the texture reference index for a material whose vmt textures have changed, e.g. after a reimport. */
+	virtual void NotifyMaterialTexturesChanged(const UMaterialInterface* material) = 0;
+
 	virtual void FindEntitiesByTargetName(UWorld* world, const FName targetName, TArray<ABaseEntity*>& outEntities) const = 0;
 
 };
\ No newline at end of file
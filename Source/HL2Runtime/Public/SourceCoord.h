@@ -11,6 +11,11 @@ private:
 	const FTransform3f transform;
 	const bool reverseWinding;
 
+	// When every axis maps onto a distinct axis with the same magnitude, positions and directions are converted by shuffling and scaling components
+	bool isAxisPermutation;
+	int32 axisPermutation[3];
+	FVector3f axisScale;
+
 public:
 
 	inline FSourceCoord(const FVector3f& unitX, const FVector3f& unitY, const FVector3f& unitZ);
@@ -35,13 +40,61 @@ public:
 
 	inline FPlane4f Plane(const FPlane4f& inPlane) const;
 
+	/** Gets whether this is a pure axis permutation with sign flips and a uniform scale, for which positions and directions take a faster path. */
+	inline bool IsAxisPermutation() const;
+
+	/** Converts many positions at once, giving exactly the same results as Position. The views may alias. */
+	HL2RUNTIME_API void Positions(TArrayView<const FVector3f> inPositions, TArrayView<FVector3f> outPositions) const;
+
+	/** Converts many directions at once, giving exactly the same results as Direction. The views may alias. */
+	HL2RUNTIME_API void Directions(TArrayView<const FVector3f> inDirections, TArrayView<FVector3f> outDirections) const;
+
+	/** Converts many quaternions at once, giving exactly the same results as Quat. The views may alias. */
+	HL2RUNTIME_API void Quats(TArrayView<const FQuat4f> inQuats, TArrayView<FQuat4f> outQuats) const;
+
+	/** Converts many transforms at once, giving exactly the same results as Transform. The views may alias. */
+	HL2RUNTIME_API void Transforms(TArrayView<const FTransform3f> inTransforms, TArrayView<FTransform3f> outTransforms) const;
+
+private:
+
+	/**
+	 * Normalises four directions held across lanes like GetSafeNormal, but with an exactly rounded reciprocal square root,
+	 * so that the batched and single conversions agree on every platform.
+	 */
+	static FORCEINLINE void SafeNormalLanes(VectorRegister4Float& x, VectorRegister4Float& y, VectorRegister4Float& z);
+
 };
 
 inline FSourceCoord::FSourceCoord(const FVector3f& unitX, const FVector3f& unitY, const FVector3f& unitZ)
 	: matrix(FMatrix44f(unitX, unitY, unitZ, FVector3f::ZeroVector))
 	, transform(matrix)
 	, reverseWinding(matrix.Determinant() < 0.0f)
-{ }
+	, isAxisPermutation(true)
+{
+	// Output axis j takes input axis i when unit i only points along axis j
+	const FVector3f units[3] = { unitX, unitY, unitZ };
+	const float magnitude = units[0].GetAbsMax();
+	bool claimed[3] = { false, false, false };
+	for (int32 j = 0; j < 3; ++j)
+	{
+		axisPermutation[j] = 0;
+		axisScale[j] = 0.0f;
+	}
+	for (int32 i = 0; i < 3 && isAxisPermutation; ++i)
+	{
+		int32 nonZeroCount = 0;
+		for (int32 j = 0; j < 3; ++j)
+		{
+			if (units[i][j] == 0.0f) { continue; }
+			++nonZeroCount;
+			if (claimed[j] || FMath::Abs(units[i][j]) != magnitude) { isAxisPermutation = false; }
+			claimed[j] = true;
+			axisPermutation[j] = i;
+			axisScale[j] = units[i][j];
+		}
+		if (nonZeroCount != 1) { isAxisPermutation = false; }
+	}
+}
 
 inline bool FSourceCoord::ShouldReverseWinding() const
 {
@@ -58,14 +111,35 @@ inline const FTransform3f& FSourceCoord::GetTransform() const
 	return transform;
 }
 
+inline bool FSourceCoord::IsAxisPermutation() const
+{
+	return isAxisPermutation;
+}
+
 inline FVector3f FSourceCoord::Position(const FVector3f& inPosition) const
 {
-	return transform.TransformPosition(inPosition);
+	if (!isAxisPermutation) { return transform.TransformPosition(inPosition); }
+	return FVector3f(
+		inPosition[axisPermutation[0]] * axisScale.X,
+		inPosition[axisPermutation[1]] * axisScale.Y,
+		inPosition[axisPermutation[2]] * axisScale.Z
+	);
 }
 
 inline FVector3f FSourceCoord::Direction(const FVector3f& inDirection) const
 {
-	return transform.TransformVector(inDirection).GetSafeNormal();
+	if (!isAxisPermutation) { return transform.TransformVector(inDirection).GetSafeNormal(); }
+
+	// Scaled before normalising so that tiny directions collapse to zero exactly as with the general transform
+	VectorRegister4Float x = VectorSetFloat1(inDirection[axisPermutation[0]] * axisScale.X);
+	VectorRegister4Float y = VectorSetFloat1(inDirection[axisPermutation[1]] * axisScale.Y);
+	VectorRegister4Float z = VectorSetFloat1(inDirection[axisPermutation[2]] * axisScale.Z);
+	SafeNormalLanes(x, y, z);
+	FVector3f outDirection;
+	VectorStoreFloat1(x, &outDirection.X);
+	VectorStoreFloat1(y, &outDirection.Y);
+	VectorStoreFloat1(z, &outDirection.Z);
+	return outDirection;
 }
 
 inline FRotator3f FSourceCoord::Rotator(const FRotator3f& inRotator) const
@@ -90,6 +164,17 @@ inline FPlane4f FSourceCoord::Plane(const FPlane4f& inPlane) const
 	return inPlane.TransformBy(matrix);
 }
 
+FORCEINLINE void FSourceCoord::SafeNormalLanes(VectorRegister4Float& x, VectorRegister4Float& y, VectorRegister4Float& z)
+{
+	const VectorRegister4Float squareSum = VectorAdd(VectorAdd(VectorMultiply(x, x), VectorMultiply(y, y)), VectorMultiply(z, z));
+	const VectorRegister4Float scale = VectorDivide(VectorOneFloat(), VectorSqrt(squareSum));
+	const VectorRegister4Float isUnit = VectorCompareEQ(squareSum, VectorOneFloat());
+	const VectorRegister4Float isZero = VectorCompareLT(squareSum, VectorSetFloat1(SMALL_NUMBER));
+	x = VectorSelect(isZero, VectorZeroFloat(), VectorSelect(isUnit, x, VectorMultiply(x, scale)));
+	y = VectorSelect(isZero, VectorZeroFloat(), VectorSelect(isUnit, y, VectorMultiply(y, scale)));
+	z = VectorSelect(isZero, VectorZeroFloat(), VectorSelect(isUnit, z, VectorMultiply(z, scale)));
+}
+
 constexpr float SOURCE_UNIT_SCALE = 2.54f; // inches to cm
 
 const FSourceCoord SourceToUnreal(
@@ -10,22 +10,41 @@
 class ABaseEntity;
 class AStaticMeshActor;
 
+/** A contiguous range of elements within one of the flat pools of AVBSPInfo. */
 USTRUCT(BlueprintType)
-struct FVBSPNode
+struct FVBSPRange
 {
 	GENERATED_BODY()
 
 public:
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	int Left;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	int32 Offset = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	int32 Count = 0;
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	int Right;
+};
 
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+USTRUCT(BlueprintType)
+struct FVBSPNode
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The splitting plane of this node. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	FPlane4f Plane;
 
+	/** The child on the front side of the plane. Negative values are leaves, encoded as -(1 + leafIndex). */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	int32 Front = 0;
+
+	/** The child on the back side of the plane. Negative values are leaves, encoded as -(1 + leafIndex). */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	int32 Back = 0;
+
 };
 
 USTRUCT(BlueprintType)
@@ -35,17 +54,113 @@ struct FVBSPLeaf
 
 public:
 
-	/** All cells that intersect this leaf. */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	TSet<AStaticMeshActor*> Cells;
-
 	/** The cluster to which this leaf belongs, or -1. */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	int Cluster;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	int32 Cluster = -1;
 
 	/** Whether this leaf is considered solid. */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	bool Solid;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	bool Solid = false;
+
+	/** The planes that bound this leaf, as a range into LeafPlanePool. An empty range means the bounds are unknown. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVBSPRange Planes;
+
+	/** The brushes that intersect this leaf, as a range into LeafBrushPool. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVBSPRange Brushes;
+
+};
+
+/** The contents flags of a brush, matching the values used by vbsp. */
+namespace EVBSPContents
+{
+	constexpr int32 Solid = 0x1;
+	constexpr int32 Window = 0x2;
+	constexpr int32 Grate = 0x8;
+	constexpr int32 Moveable = 0x4000;
+	constexpr int32 PlayerClip = 0x10000;
+	constexpr int32 MonsterClip = 0x20000;
+	constexpr int32 Monster = 0x2000000;
+
+	constexpr int32 MaskSolid = Solid | Moveable | Window | Monster | Grate;
+	constexpr int32 MaskPlayerSolid = MaskSolid | PlayerClip;
+	constexpr int32 MaskNPCSolid = MaskSolid | MonsterClip;
+}
+
+USTRUCT(BlueprintType)
+struct FVBSPBrush
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The sides of this convex brush, as a range into BrushSides. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVBSPRange Sides;
+
+	/** The contents flags of this brush, see EVBSPContents. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	int32 Contents = 0;
+
+};
+
+USTRUCT(BlueprintType)
+struct FVBSPBrushSide
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The plane of this side, facing out of the brush. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FPlane4f Plane;
+
+	/** Whether this side is a bevel added by vbsp so that box traces do not catch on sharp edges. Rays ignore bevels. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	bool Bevel = false;
+
+};
+
+/** The outcome of a hull trace against the brushes of the world. */
+USTRUCT(BlueprintType)
+struct FVBSPTraceResult
+{
+	GENERATED_BODY()
+
+public:
+
+	/** How far along the trace the hull got before hitting something, from 0 to 1. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	float Fraction = 1.0f;
+
+	/** The center of the hull at the end of the trace. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVector3f EndPos = FVector3f::ZeroVector;
+
+	/** The normal of the brush side that was hit. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVector3f Normal = FVector3f::ZeroVector;
+
+	/** Whether the hull started inside a brush. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	bool StartSolid = false;
+
+	/** Whether the hull never left a brush. Fraction is 0 when set. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	bool AllSolid = false;
+
+	/** The contents of the brush that was hit, or 0. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	int32 Contents = 0;
+
+	/** The index of the brush that was hit, or -1. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	int32 Brush = -1;
+
+public:
+
+	bool IsHit() const { return Brush >= 0 || StartSolid; }
 
 };
 
@@ -56,17 +171,21 @@ struct FVBSPCluster
 
 public:
 
-	/** All cells that intersect this cluster. */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	TSet<AStaticMeshActor*> Cells;
+	/** All leaves contained within this cluster, as a range into LeafPool. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVBSPRange Leaves;
+
+	/** All clusters that can be seen from this cluster, as a range into VisibilityPool. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVBSPRange VisibleClusters;
 
-	/** All clusters that can be seen from this cluster. */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	TSet<int> VisibleClusters;
+	/** All cells that intersect this cluster, as a range into ActorPool. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVBSPRange Cells;
 
-	/** All leaves contained within this cluster. */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly)
-	TSet<int> Leaves;
+	/** All entities whose origin lies within this cluster, as a range into ActorPool. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	FVBSPRange Entities;
 
 };
 
@@ -74,10 +193,10 @@ UCLASS()
 class HL2RUNTIME_API AVBSPInfo : public AActor
 {
 	GENERATED_BODY()
-	
+
 public:
 
-	/** The VBSP nodes. */
+	/** The VBSP nodes. Node 0 is the root of the world model. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	TArray<FVBSPNode> Nodes;
 
@@ -85,35 +204,132 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	TArray<FVBSPLeaf> Leaves;
 
-	/** The VBSP clusters. */
+	/** The VBSP clusters, indexed by the cluster index used in the vbsp visibility data. */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
 	TArray<FVBSPCluster> Clusters;
 
+	/** Leaf indices referenced by FVBSPCluster::Leaves. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<int32> LeafPool;
+
+	/** Cluster indices referenced by FVBSPCluster::VisibleClusters. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<int32> VisibilityPool;
+
+	/** Actors referenced by FVBSPCluster::Cells and FVBSPCluster::Entities. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<AActor*> ActorPool;
+
+	/** Actors that render the brushes of the world model, whose collision is already covered by the hull traces. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<AActor*> BrushGeometry;
+
+	/** Bounding planes referenced by FVBSPLeaf::Planes, oriented so that points inside the leaf are in front. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<FPlane4f> LeafPlanePool;
+
+	/** The brushes of the world model. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<FVBSPBrush> Brushes;
+
+	/** Brush sides referenced by FVBSPBrush::Sides. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<FVBSPBrushSide> BrushSides;
+
+	/** Brush indices referenced by FVBSPLeaf::Brushes. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HL2")
+	TArray<int32> LeafBrushPool;
+
 public:
 
 	/** Gets the leaf that contains the position, or -1 if the position is outside the BSP tree. */
 	UFUNCTION(BlueprintCallable, Category = "HL2")
 	int FindLeaf(const FVector3f& pos) const;
 
+	/**
+	 * Gets the leaves that contain each of the positions, or -1 for positions outside the BSP tree.
+	 * On entry, outLeaves may hold the leaf last found for each position (or -1), for example one slot per actor kept between frames.
+	 * Positions still inside their previous leaf only have that leaf's bounding planes tested, the rest are traversed four at a time.
+	 * Points lying exactly on a plane shared between two leaves may report either leaf.
+	 */
+	void FindLeaves(TArrayView<const FVector> positions, TArrayView<int32> outLeaves) const;
+
+	/** Gets whether the position is within the bounding planes of the leaf. */
+	bool IsInLeaf(const FVector3f& pos, const int leafIndex) const;
+
 	/** Gets the cluster that contains the position, or -1 if the position is not inside a cluster. */
 	UFUNCTION(BlueprintCallable, Category = "HL2")
 	int FindCluster(const FVector3f& pos) const;
 
+	/** Finds all leaves that the box touches. Leaves shared between nodes may be listed more than once. */
+	void FindLeavesInBox(const FBox3f& box, TArray<int32>& outLeaves) const;
+
+	/** Finds all clusters that have a leaf touching the box, in no particular order. Nothing is found if the box only touches solid leaves or the void. */
+	void FindClustersInBox(const FBox3f& box, TArray<int32>& outClusters) const;
+
 	/** Finds all clusters that are reachable from the specified one. */
 	UFUNCTION(BlueprintCallable, Category = "HL2")
 	void FindReachableClusters(const int baseCluster, TSet<int>& out) const;
 
-	/** Finds all entities that are contained within the cluster. Only checks origin point of entity, not entire bounds. */
+	/** Finds all cells that intersect the cluster. */
+	UFUNCTION(BlueprintCallable, Category = "HL2")
+	void FindCellsInCluster(const int clusterIndex, TArray<AStaticMeshActor*>& out) const;
+
+	/** Finds all entities that are contained within the cluster. Only checks origin point of entity at import time, not entire bounds. */
 	UFUNCTION(BlueprintCallable, Category = "HL2")
 	void FindEntitiesInCluster(const int clusterIndex, TSet<ABaseEntity*>& out) const;
 
-	/** Finds all entities that are contained within one of the clusters. Only checks origin point of entity, not entire bounds. */
+	/** Finds all entities that are contained within one of the clusters. Only checks origin point of entity at import time, not entire bounds. */
 	UFUNCTION(BlueprintCallable, Category = "HL2")
 	void FindEntitiesInClusters(const TSet<int>& clusterIndices, TSet<ABaseEntity*>& out) const;
 
+	/** Gets the leaf indices contained within the cluster. */
+	TArrayView<const int32> GetClusterLeaves(const int clusterIndex) const;
+
+	/** Gets the cluster indices visible from the cluster. */
+	TArrayView<const int32> GetClusterVisibility(const int clusterIndex) const;
+
+	/** Gets whether brushes were imported, and so whether hull traces can hit anything. */
+	bool HasBrushes() const { return Brushes.Num() > 0; }
+
+	/**
+	 * Sweeps an axis-aligned box with the given half extents from start to end against every world brush whose contents match the mask.
+	 * Follows the clip hull rules of Source, so the box stops a small epsilon short of the surface and slides along bevelled edges.
+	 * Traces do not allocate and give the same result for the same inputs.
+	 */
+	FVBSPTraceResult TraceBox(const FVector3f& start, const FVector3f& end, const FVector3f& extents, int32 contentsMask = EVBSPContents::MaskPlayerSolid) const;
+
+	/** Traces a ray from start to end against every world brush whose contents match the mask. Bevel sides are ignored. */
+	FVBSPTraceResult TraceRay(const FVector3f& start, const FVector3f& end, int32 contentsMask = EVBSPContents::MaskSolid) const;
+
+#if WITH_EDITOR
+
+	/** Replaces the cluster-to-actor index with the given cells and entities, packing them into ActorPool. */
+	void SetClusterActors(const TArray<TArray<AStaticMeshActor*>>& cellsByCluster, const TArray<TArray<ABaseEntity*>>& entitiesByCluster);
+
+	/** Rebuilds the cluster-to-entity index from all entities currently in the world, keeping the cell index intact. */
+	void RebuildEntityIndex();
+
+	/** Computes the non-redundant bounding planes of every leaf from the node tree. */
+	void BuildLeafBoundingPlanes();
+
+#endif
+
 protected:
 
 	UFUNCTION()
 	int NodeIDToLeafID(int nodeID) const;
 
+	TArrayView<AActor* const> GetActorRange(const FVBSPRange& range) const;
+
+private:
+
+	struct FTraceWork;
+
+	void TraceNode(FTraceWork& work, int32 nodeID, float startFraction, float endFraction, const FVector3f& start, const FVector3f& end) const;
+
+	void TraceLeaf(FTraceWork& work, int32 leafID) const;
+
+	void ClipToBrush(FTraceWork& work, int32 brushIndex) const;
+
 };
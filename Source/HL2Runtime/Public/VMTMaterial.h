@@ -11,13 +11,20 @@ class HL2RUNTIME_API UVMTMaterial : public UMaterialInstanceConstant
 	GENERATED_BODY()
 
 public:
+
+	/** The hidden asset registry tag listing the asset paths of all textures referenced by the vmt, so that they can be found without loading the material. */
+	static const FName TexturesTagName;
 	
 	bool DoesReferenceTexture(FName assetPath) const;
 
+	/** Parses the value of TexturesTagName back into texture asset paths. */
+	static void ParseTexturesTag(const FString& tagValue, TArray<FName>& outTextures);
+
 	virtual void PostInitProperties() override;
 
-#if WITH_EDITORONLY_DATA
 	virtual void GetAssetRegistryTags(TArray<FAssetRegistryTag>& OutTags) const override;
+
+#if WITH_EDITORONLY_DATA
 	virtual void Serialize(FArchive& Ar) override;
 #endif
 